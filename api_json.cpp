@@ -0,0 +1,528 @@
+// api_json.cpp
+// JSON <-> struct conversion for the HTTP API, kept out of server.cpp so the
+// benchmarks can drive it without a running server.
+#include "api_json.h"
+#include "food_store.h"
+#include <climits>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+
+// --- small helpers to map strings <-> enums ---
+
+Sex parseSex(const string& s) {
+    if (s == "male" || s == "Male" || s == "M") return Sex::Male;
+    return Sex::Female;
+}
+
+Activity parseActivity(const string& s) {
+    if (s == "sedentary")  return Activity::Sedentary;
+    if (s == "light")      return Activity::Light;
+    if (s == "moderate")   return Activity::Moderate;
+    if (s == "very")       return Activity::Very;
+    if (s == "extra")      return Activity::Extra;
+    return Activity::Moderate;
+}
+
+Goal parseGoal(const string& s) {
+    if (s == "cut")      return Goal::Cut;
+    if (s == "bulk")     return Goal::Bulk;
+    return Goal::Maintain;
+}
+
+Pace parsePace(const string& s) {
+    if (s == "slow")       return Pace::Slow;
+    if (s == "aggressive") return Pace::Aggressive;
+    return Pace::Normal;
+}
+
+const char* sexName(Sex s) {
+    return s == Sex::Male ? "male" : "female";
+}
+
+const char* activityName(Activity a) {
+    switch (a) {
+        case Activity::Sedentary: return "sedentary";
+        case Activity::Light:     return "light";
+        case Activity::Moderate:  return "moderate";
+        case Activity::Very:      return "very";
+        case Activity::Extra:     return "extra";
+        default:                  return "moderate";
+    }
+}
+
+const char* goalName(Goal g) {
+    switch (g) {
+        case Goal::Cut:  return "cut";
+        case Goal::Bulk: return "bulk";
+        default:         return "maintain";
+    }
+}
+
+const char* paceName(Pace p) {
+    switch (p) {
+        case Pace::Slow:       return "slow";
+        case Pace::Aggressive: return "aggressive";
+        default:               return "normal";
+    }
+}
+
+const char* breakerStateName(CircuitBreaker::State s) {
+    switch (s) {
+        case CircuitBreaker::OPEN:      return "open";
+        case CircuitBreaker::HALF_OPEN: return "half_open";
+        default:                        return "closed";
+    }
+}
+
+static const BmrFormula BMR_FORMULAS[BMR_FORMULA_COUNT] = {
+    BmrFormula::MifflinStJeor, BmrFormula::HarrisBenedict, BmrFormula::KatchMcArdle, BmrFormula::Cunningham
+};
+
+bool parseBmrFormula(const string& s, BmrFormula& out) {
+    for (BmrFormula f : BMR_FORMULAS) {
+        if (s == bmrFormulaName(f)) {
+            out = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* bmrFormulaName(BmrFormula f) {
+    switch (f) {
+        case BmrFormula::HarrisBenedict: return HarrisBenedict::NAME;
+        case BmrFormula::KatchMcArdle:   return KatchMcArdle::NAME;
+        case BmrFormula::Cunningham:     return Cunningham::NAME;
+        default:                         return MifflinStJeor::NAME;
+    }
+}
+
+// --- exception-free JSON field access ---
+// Handlers parse with allow_exceptions=false and these checks, so malformed
+// bodies are rejected without throwing.
+
+bool readString(const json& obj, const char* key, string& out) {
+    auto it = obj.find(key);
+    if (it == obj.end() || !it->is_string()) return false;
+    out = it->get_ref<const string&>();
+    return true;
+}
+
+bool readNumber(const json& obj, const char* key, double& out) {
+    auto it = obj.find(key);
+    if (it == obj.end() || !it->is_number()) return false;
+    out = it->get<double>();
+    return true;
+}
+
+bool readInt(const json& obj, const char* key, int& out) {
+    double value;
+    if (!readNumber(obj, key, value) || !(value >= INT_MIN && value <= INT_MAX)) return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+// --- JSON <-> planner structs ---
+
+// Returns false and names the offending field in error when the body is malformed.
+bool parseUserInput(const json& body, UserInput& u, string& error) {
+    string sex, activity, goal, pace;
+    const char* field = nullptr;
+    if (!body.is_object())                            field = "body";
+    else if (!readString(body, "sex", sex))           field = "sex";
+    else if (!readInt(body, "age", u.ageYears))       field = "age";
+    else if (!readNumber(body, "height_cm", u.height)) field = "height_cm";
+    else if (!readNumber(body, "weight_kg", u.weight)) field = "weight_kg";
+    else if (!readString(body, "activity", activity)) field = "activity";
+    else if (!readString(body, "goal", goal))         field = "goal";
+    else if (!readString(body, "pace", pace))         field = "pace";
+    else if (body.contains("body_fat_pct") && !readNumber(body, "body_fat_pct", u.bodyFatPct))
+        field = "body_fat_pct";
+
+    if (field) {
+        error = string("missing or invalid field '") + field + "'";
+        return false;
+    }
+
+    u.units    = Units::Metric;
+    u.sex      = parseSex(sex);
+    u.activity = parseActivity(activity);
+    u.goal     = parseGoal(goal);
+    u.pace     = parsePace(pace);
+    return true;
+}
+
+namespace {
+    bool readAxis(const json& body, const char* key, GridAxis& axis, string& error) {
+        auto it = body.find(key);
+        if (it == body.end()) {
+            error = string("missing field '") + key + "'";
+            return false;
+        }
+        if (it->is_number()) {
+            axis.from = axis.to = it->get<double>();
+            axis.step = 0.0;
+            return true;
+        }
+        if (!it->is_object() || !readNumber(*it, "from", axis.from) || !readNumber(*it, "to", axis.to)
+            || !readNumber(*it, "step", axis.step) || !(axis.step > 0.0) || axis.to < axis.from) {
+            error = string("field '") + key + "' must be a number or {from, to, step} with step > 0";
+            return false;
+        }
+        return true;
+    }
+
+    // Reads an array of enum names, or every value when the key is absent.
+    template <class E>
+    bool readEnumList(const json& body, const char* key, E (*parse)(const string&),
+                      const vector<E>& all, vector<E>& out, string& error) {
+        auto it = body.find(key);
+        if (it == body.end()) {
+            out = all;
+            return true;
+        }
+        if (!it->is_array() || it->empty()) {
+            error = string("field '") + key + "' must be a non-empty array of names";
+            return false;
+        }
+        for (const auto& name : *it) {
+            if (!name.is_string()) {
+                error = string("field '") + key + "' must be a non-empty array of names";
+                return false;
+            }
+            out.push_back(parse(name.get_ref<const string&>()));
+        }
+        return true;
+    }
+}
+
+bool parsePlanGrid(const json& body, PlanGrid& grid, string& error) {
+    if (!body.is_object()) {
+        error = "body must be an object";
+        return false;
+    }
+    if (!readAxis(body, "age", grid.age, error) ||
+        !readAxis(body, "height_cm", grid.height, error) ||
+        !readAxis(body, "weight_kg", grid.weight, error)) return false;
+
+    if (!readEnumList<Sex>(body, "sex", parseSex, {Sex::Male, Sex::Female}, grid.sexes, error) ||
+        !readEnumList<Activity>(body, "activity", parseActivity,
+                                {Activity::Sedentary, Activity::Light, Activity::Moderate, Activity::Very, Activity::Extra},
+                                grid.activities, error) ||
+        !readEnumList<Goal>(body, "goal", parseGoal, {Goal::Cut, Goal::Maintain, Goal::Bulk}, grid.goals, error) ||
+        !readEnumList<Pace>(body, "pace", parsePace, {Pace::Slow, Pace::Normal, Pace::Aggressive}, grid.paces, error))
+        return false;
+
+    if (grid.size() > MAX_GRID_ROWS) {
+        error = "grid has more than " + to_string(MAX_GRID_ROWS) + " rows";
+        return false;
+    }
+    return true;
+}
+
+bool parseWeeklyPlanOptions(const json& body, WeeklyPlanOptions& opt, string& error) {
+    struct IntField { const char* key; int* value; int min, max; };
+    const IntField ints[] = {
+        { "days",           &opt.days,         1, MAX_PLAN_DAYS },
+        { "foods_per_meal", &opt.foodsPerMeal, 1, 10 },
+        { "max_repeats",    &opt.maxRepeats,   1, MAX_PLAN_DAYS * 10 },
+        { "time_budget_ms", &opt.timeBudgetMs, 1, MAX_PLAN_TIME_BUDGET_MS },
+    };
+    for (const auto& f : ints) {
+        if (!body.contains(f.key)) continue;
+        if (!readInt(body, f.key, *f.value) || *f.value < f.min || *f.value > f.max) {
+            error = string(f.key) + " must be an integer between " + to_string(f.min) + " and " + to_string(f.max);
+            return false;
+        }
+    }
+
+    if (!body.contains("meals")) return true;
+    const json& meals = body["meals"];
+    if (!meals.is_array() || meals.empty() || meals.size() > 10) {
+        error = "meals must be an array of 1 to 10 {\"name\", \"share\"} objects";
+        return false;
+    }
+    opt.meals.clear();
+    for (size_t i = 0; i < meals.size(); ++i) {
+        MealSlot slot;
+        if (!meals[i].is_object() || !readString(meals[i], "name", slot.name) ||
+            !readNumber(meals[i], "share", slot.share) || !(slot.share > 0)) {
+            error = "meals[" + to_string(i) + "] needs a name and a positive share";
+            return false;
+        }
+        opt.meals.push_back(slot);
+    }
+    return true;
+}
+
+// Request-side name for each PlanStatus bit.
+const char* jsonFieldName(PlanStatus field) {
+    switch (field) {
+        case PLAN_BAD_WEIGHT:   return "weight_kg";
+        case PLAN_BAD_HEIGHT:   return "height_cm";
+        case PLAN_BAD_AGE:      return "age";
+        case PLAN_BAD_BODY_FAT: return "body_fat_pct";
+        default:                return "unknown";
+    }
+}
+
+// {"error": <first message>, "fields": {<field>: <message>, ...}} for every bad field.
+json planErrorToJson(unsigned char status) {
+    json err;
+    err["error"]  = string("Bad request: ") + planStatusMessage(status);
+    err["fields"] = json::object();
+    for (const auto& e : PLAN_FIELD_ERRORS) {
+        if (status & e.field) err["fields"][jsonFieldName(e.field)] = e.message;
+    }
+    return err;
+}
+
+json planToJson(const PlanResult& r) {
+    json out;
+    out["bmr"]            = r.bmr;
+    out["tdee"]           = r.tdee;
+    out["targetCalories"] = r.targetCalories;
+    out["weeklyChangeKg"] = r.weeklyChangeKg;
+    out["weeklyChangeLb"] = r.weeklyChangeLb;
+
+    out["macros"] = {
+        {"calories",  r.macros.calories},
+        {"protein_g", r.macros.protein_g},
+        {"fat_g",     r.macros.fat_g},
+        {"carbs_g",   r.macros.carbs_g}
+    };
+    return out;
+}
+
+json recommendationsToJson(const FoodRecommendations& recommendations) {
+    json out;
+    out["goal"] = recommendations.goal_type;
+    out["foods"] = json::array();
+
+    const FoodRows foods = recommendations.foods();
+    const bool portions = recommendations.grams.size() == foods.size() && !recommendations.grams.empty();
+    double total[4] = {};
+    for (size_t i = 0; i < foods.size(); ++i) {
+        const FoodRef food = foods[i];
+        json foodJson;
+        foodJson["id"] = food.fdcId();
+        foodJson["name"] = food.description();
+        foodJson["calories"] = food.calories();
+        foodJson["protein_g"] = food.protein_g();
+        foodJson["carbs_g"] = food.carbs_g();
+        foodJson["fat_g"] = food.fat_g();
+        // Everything beyond the macros that the source reported, per 100 g
+        json extra = json::object();
+        for (int n = NUTRIENT_FIBER; n < NUTRIENT_COUNT; ++n) {
+            double amount = food.amount(Nutrient(n));
+            if (amount != 0.0) extra[NUTRIENT_KEYS[n]] = amount;
+        }
+        foodJson["nutrients"] = extra;
+        if (portions) {
+            // Nutrients above are per 100 g
+            double scale = recommendations.grams[i] / 100.0;
+            foodJson["grams"] = recommendations.grams[i];
+            total[0] += food.calories() * scale;
+            total[1] += food.protein_g() * scale;
+            total[2] += food.carbs_g() * scale;
+            total[3] += food.fat_g() * scale;
+        }
+        out["foods"].push_back(foodJson);
+    }
+    if (portions) {
+        out["totals"] = {
+            {"calories",  total[0]},
+            {"protein_g", total[1]},
+            {"carbs_g",   total[2]},
+            {"fat_g",     total[3]}
+        };
+        out["withinTolerance"] = recommendations.withinTolerance;
+    }
+    return out;
+}
+
+namespace {
+    json macrosToJson(const MacroPlan& m) {
+        return {
+            {"calories",  m.calories},
+            {"protein_g", m.protein_g},
+            {"fat_g",     m.fat_g},
+            {"carbs_g",   m.carbs_g}
+        };
+    }
+}
+
+// {"days": [{"day", "meals": [{"name", "target", "totals", "foods": [...]}]}], "groceries": [...]}
+json weeklyPlanToJson(const WeeklyPlan& plan, const FoodTable& foods, const WeeklyPlanOptions& opt) {
+    json out;
+    out["days"] = json::array();
+    for (const auto& meal : plan.meals) {
+        if (meal.slot == 0) out["days"].push_back({ {"day", meal.day + 1}, {"meals", json::array()} });
+        json mealJson;
+        mealJson["name"]   = opt.meals[meal.slot].name;
+        mealJson["target"] = macrosToJson(meal.target);
+        mealJson["totals"] = macrosToJson(meal.totals);
+        mealJson["foods"]  = json::array();
+        for (const auto& p : meal.portions) {
+            mealJson["foods"].push_back({ {"id", foods.fdcId(p.food)}, {"name", foods.description(p.food)},
+                                          {"grams", p.grams} });
+        }
+        out["days"].back()["meals"].push_back(mealJson);
+    }
+
+    out["groceries"] = json::array();
+    for (const auto& g : plan.groceries) {
+        out["groceries"].push_back({ {"id", foods.fdcId(g.food)}, {"name", foods.description(g.food)},
+                                     {"grams", g.grams}, {"meals", g.meals} });
+    }
+    out["score"]           = plan.score;
+    out["withinTolerance"] = plan.withinTolerance;
+    out["evaluated"]       = plan.evaluated;
+    out["threads"]         = plan.threads;
+    return out;
+}
+
+json suggestionsToJson(const string& query, const FoodStore* store,
+                       const vector<FoodSuggester::Suggestion>& suggestions) {
+    json out;
+    out["query"] = query;
+    out["suggestions"] = json::array();
+    for (const auto& s : suggestions) {
+        json item;
+        item["id"] = store->fdcId(s.food);
+        item["name"] = string(store->description(s.food));
+        item["count"] = s.count;   // foods sharing this description
+        out["suggestions"].push_back(item);
+    }
+    return out;
+}
+
+json foodCacheStatsToJson(const FoodCacheStats& stats) {
+    json out;
+    out["hits"]        = stats.hits;
+    out["misses"]      = stats.misses;
+    out["coalesced"]   = stats.coalesced;
+    out["evictions"]   = stats.evictions;
+    out["rejections"]  = stats.rejections;
+    out["expirations"] = stats.expirations;
+    out["staleServed"] = stats.staleServed;
+    out["diskHits"]    = stats.diskHits;
+    out["entries"]     = stats.entries;
+    out["bytes"]       = stats.bytes;
+    const uint64_t lookups = stats.hits + stats.misses;
+    out["hitRate"]     = lookups ? double(stats.hits) / lookups : 0.0;
+    if (stats.disk.open) {
+        json disk;
+        disk["entries"]     = stats.disk.entries;
+        disk["fileBytes"]   = stats.disk.fileBytes;
+        disk["liveBytes"]   = stats.disk.liveBytes;
+        disk["hits"]        = stats.disk.hits;
+        disk["bloomSkips"]  = stats.disk.bloomSkips;
+        disk["writes"]      = stats.disk.writes;
+        disk["corrupt"]     = stats.disk.corrupt;
+        disk["compactions"] = stats.disk.compactions;
+        out["disk"] = disk;
+    }
+    return out;
+}
+
+json usdaClientStatsToJson(const UsdaClientStats& stats) {
+    json out;
+    out["breaker"]        = breakerStateName(stats.breaker);
+    out["requests"]       = stats.requests;
+    out["failures"]       = stats.failures;
+    out["shortCircuited"] = stats.shortCircuited;
+    out["hedges"]         = stats.hedges;
+    out["hedgeWins"]      = stats.hedgeWins;
+    out["p50Ms"]          = stats.p50Ms;
+    out["p95Ms"]          = stats.p95Ms;
+    out["hedgeAfterMs"]   = stats.hedgeAfterMs;
+    out["connectTimeoutMs"] = stats.connectTimeoutMs;
+    out["timeoutMs"]        = stats.timeoutMs;
+
+    // Budget left per key and how long callers queued for it
+    const QuotaStats& q = stats.quota;
+    json quota;
+    quota["remaining"] = floor(q.remaining);
+    quota["capacity"]  = q.capacity;
+    quota["granted"]   = q.granted;
+    quota["rejected"]  = q.rejected;
+    quota["hedges"]    = q.hedges;
+    quota["hedgesDenied"] = q.hedgesDenied;
+    quota["keys"]      = json::array();
+    for (const auto& k : q.keys) {
+        quota["keys"].push_back({ {"key", k.key}, {"remaining", floor(k.tokens)}, {"capacity", k.capacity},
+                                  {"granted", k.granted}, {"hedges", k.hedges}, {"exhausted", k.exhausted} });
+    }
+    const char* names[USDA_PRIORITIES] = { "interactive", "background" };
+    for (int p = 0; p < USDA_PRIORITIES; ++p) {
+        quota["queued"][names[p]] = q.queued[p];
+        quota["waitMs"][names[p]] = { {"avg", q.avgWaitMs[p]}, {"max", q.maxWaitMs[p]} };
+    }
+    out["quota"] = quota;
+    return out;
+}
+
+json trajectoryToJson(const PlanTrajectory& trajectory) {
+    json out;
+    out["weeks"] = json::array();
+    for (const auto& w : trajectory.weeks) {
+        out["weeks"].push_back({
+            {"week",           w.week},
+            {"weight_kg",      w.weightKg},
+            {"bmr",            w.bmr},
+            {"tdee",           w.tdee},
+            {"targetCalories", w.targetCalories},
+            {"weeklyChangeKg", w.weeklyChangeKg}
+        });
+    }
+    if (trajectory.weeksToTarget >= 0) out["weeksToTarget"] = trajectory.weeksToTarget;
+    else                               out["weeksToTarget"] = nullptr;
+    return out;
+}
+
+json bmrComparisonToJson(const BmrComparison& cmp, size_t i) {
+    json out = json::object();
+    for (BmrFormula formula : BMR_FORMULAS) {
+        size_t f = static_cast<size_t>(formula);
+        if (cmp.status[f][i] == PLAN_OK) {
+            out[bmrFormulaName(formula)] = {
+                {"bmr",            cmp.bmr[f][i]},
+                {"tdee",           cmp.tdee[f][i]},
+                {"targetCalories", cmp.targetCalories[f][i]}
+            };
+        } else {
+            out[bmrFormulaName(formula)] = planErrorToJson(cmp.status[f][i]);
+        }
+    }
+    return out;
+}
+
+void appendPlanNdjson(const PlanBatchInput& in, const PlanBatchResult& r, string& out) {
+    // snprintf per row; building a json object per line would dominate the sweep
+    char line[512];
+    out.reserve(out.size() + r.size() * 300);
+    for (size_t i = 0; i < r.size(); ++i) {
+        int n = snprintf(line, sizeof line,
+            "{\"sex\":\"%s\",\"age\":%d,\"height_cm\":%.10g,\"weight_kg\":%.10g,"
+            "\"activity\":\"%s\",\"goal\":\"%s\",\"pace\":\"%s\",",
+            sexName(in.sex[i]), in.ageYears[i], in.height[i], in.weight[i],
+            activityName(in.activity[i]), goalName(in.goal[i]), paceName(in.pace[i]));
+        out.append(line, size_t(n));
+
+        if (r.status[i] == PLAN_OK) {
+            n = snprintf(line, sizeof line,
+                "\"status\":\"ok\",\"bmr\":%.10g,\"tdee\":%.10g,\"targetCalories\":%.10g,"
+                "\"weeklyChangeKg\":%.10g,\"weeklyChangeLb\":%.10g,\"macros\":{\"calories\":%.10g,"
+                "\"protein_g\":%.10g,\"fat_g\":%.10g,\"carbs_g\":%.10g}}\n",
+                r.bmr[i], r.tdee[i], r.targetCalories[i], r.weeklyChangeKg[i], r.weeklyChangeLb[i],
+                r.calories[i], r.protein_g[i], r.fat_g[i], r.carbs_g[i]);
+        } else {
+            n = snprintf(line, sizeof line, "\"status\":\"error\",\"error\":\"%s\"}\n",
+                         planStatusMessage(r.status[i]));
+        }
+        out.append(line, size_t(n));
+    }
+}
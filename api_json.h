@@ -0,0 +1,70 @@
+#ifndef API_JSON_H
+#define API_JSON_H
+
+#include <string>
+#include "json.hpp"
+#include "planner.h"
+#include "food_api.h"
+#include "plan_grid.h"
+#include "meal_plan.h"
+#include "food_suggest.h"
+#include "food_cache.h"
+#include "usda_client.h"
+
+class FoodStore;
+
+using json = nlohmann::json;
+
+// String <-> enum mapping for request fields
+Sex parseSex(const std::string& s);
+Activity parseActivity(const std::string& s);
+Goal parseGoal(const std::string& s);
+Pace parsePace(const std::string& s);
+
+const char* sexName(Sex s);
+const char* activityName(Activity a);
+const char* goalName(Goal g);
+const char* paceName(Pace p);
+const char* breakerStateName(CircuitBreaker::State s);
+
+// "mifflin_st_jeor", "harris_benedict", ...; false for an unknown name
+bool parseBmrFormula(const std::string& s, BmrFormula& out);
+const char* bmrFormulaName(BmrFormula f);
+
+// Exception-free field access; false when the key is missing or has the wrong type
+bool readString(const json& obj, const char* key, std::string& out);
+bool readNumber(const json& obj, const char* key, double& out);
+bool readInt(const json& obj, const char* key, int& out);
+
+// /plan request body -> UserInput; false with the offending field named in error
+bool parseUserInput(const json& body, UserInput& u, std::string& error);
+
+// /plan/grid spec -> PlanGrid. Numeric fields take a number or {"from", "to", "step"};
+// enum fields take an array of names and default to every value.
+bool parsePlanGrid(const json& body, PlanGrid& grid, std::string& error);
+
+// Optional /plan/week fields ("days", "meals": [{"name", "share"}], "foods_per_meal",
+// "max_repeats", "time_budget_ms") over the defaults already in opt
+bool parseWeeklyPlanOptions(const json& body, WeeklyPlanOptions& opt, std::string& error);
+
+// Request-side name for a PlanStatus bit
+const char* jsonFieldName(PlanStatus field);
+
+// Response bodies
+json planToJson(const PlanResult& r);
+json planErrorToJson(unsigned char status);
+json recommendationsToJson(const FoodRecommendations& recommendations);
+json trajectoryToJson(const PlanTrajectory& trajectory);
+json weeklyPlanToJson(const WeeklyPlan& plan, const FoodTable& foods, const WeeklyPlanOptions& opt);
+json suggestionsToJson(const std::string& query, const FoodStore* store,
+                       const std::vector<FoodSuggester::Suggestion>& suggestions);
+json foodCacheStatsToJson(const FoodCacheStats& stats);
+json usdaClientStatsToJson(const UsdaClientStats& stats);
+
+// Row i of a comparison: {<formula name>: {"bmr", "tdee", "targetCalories"} or error, ...}
+json bmrComparisonToJson(const BmrComparison& cmp, size_t i);
+
+// One NDJSON line per row (inputs plus plan or error), appended to out
+void appendPlanNdjson(const PlanBatchInput& in, const PlanBatchResult& r, std::string& out);
+
+#endif
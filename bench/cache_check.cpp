@@ -0,0 +1,82 @@
+// cache_check.cpp
+// Checks of FoodSearchCache behaviour that a wrong answer would hide behind a
+// plausible-looking hit or a missing fallback: how queries are normalised
+// into keys, and what admission does to a refresh of a cached key. Prints
+// each failed check and exits 1 if there is any.
+//
+//   ./cache_check
+#include <iostream>
+#include <string>
+
+#include "food_cache.h"
+
+using namespace std;
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const string& what) {
+    if (ok) return;
+    cout << "FAIL: " << what << "\n";
+    ++failures;
+}
+
+void keys() {
+    typedef FoodSearchCache C;
+    check(C::key("Chicken  Breast", 25) == C::key("chicken, breast", 25), "case and punctuation fold");
+    check(C::key("chicken breast", 25) != C::key("chicken breast", 5), "result count is part of the key");
+    check(C::key("豆腐", 25) != C::key("寿司", 25), "different non-Latin queries get different keys");
+    check(C::key("豆腐", 25) != C::key("", 25), "a non-Latin query is not empty");
+    check(C::key("Tofu 豆腐", 25) == C::key("tofu, 豆腐", 25), "ASCII folds next to UTF-8");
+    check(C::key("crème brûlée", 25) != C::key("crme brle", 25), "accented letters are kept");
+}
+
+FoodTable foods(int rows) {
+    FoodTable t;
+    float amount[NUTRIENT_COUNT] = { 100, 10, 5, 2 };
+    for (int r = 0; r < rows; ++r) t.add(1000 + r, "food " + to_string(r), amount);
+    return t;
+}
+
+// Bytes the cache charges for `key` holding `rows` rows
+size_t charged(const string& key, int rows) {
+    FoodSearchCache c;
+    c.getOrLoad(key, [&](FoodTable& t) { t = foods(rows); return true; });
+    return c.stats().bytes;
+}
+
+// A popular key fills most of a shard; a rarer key, cached small, is refreshed
+// with a result too big to sit beside it. The refresh must replace the old
+// entry, not lose it to admission.
+void refreshAdmission() {
+    const string popular = "popular#25";
+    string rare;
+    for (int i = 0; rare.empty(); ++i) {
+        string k = "rare " + to_string(i) + "#25";
+        if (std::hash<string>()(k) % FOOD_CACHE_SHARDS == std::hash<string>()(popular) % FOOD_CACHE_SHARDS) rare = k;
+    }
+    const size_t shard = charged(popular, 20) + charged(rare, 20) - 1;
+    FoodSearchCache c(shard * FOOD_CACHE_SHARDS, std::chrono::seconds(0));   // every entry expires at once
+
+    for (int i = 0; i < 6; ++i) c.getOrLoad(popular, [](FoodTable& t) { t = foods(20); return true; });
+    c.getOrLoad(rare, [](FoodTable& t) { t = foods(1); return true; });
+    check(c.stale(rare) != nullptr, "a small entry fits beside the popular one");
+
+    c.getOrLoad(rare, [](FoodTable& t) { t = foods(20); return true; });
+    FoodSearchCache::Value refreshed = c.stale(rare);
+    check(refreshed && refreshed->size() == 20, "a refresh of a cached key replaces it despite admission");
+}
+
+}  // namespace
+
+int main() {
+    keys();
+    refreshAdmission();
+    if (failures) {
+        cout << failures << " check(s) failed\n";
+        return 1;
+    }
+    cout << "all cache checks passed\n";
+    return 0;
+}
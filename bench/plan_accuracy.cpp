@@ -0,0 +1,260 @@
+// plan_accuracy.cpp
+// Differential check of computePlanBatchF32 and computePlanBatchFixed against the
+// double-precision computePlanBatch over the whole range validateInput accepts.
+// computePlanFor<Sex, Activity, Goal, Pace> runs the same arithmetic as the batch,
+// so every instantiation is held to rounding noise rather than display units.
+//
+//   ./plan_accuracy [--step=2.5] [--age-step=5] [--samples=10000000] [--seed=7]
+//
+// Two sweeps per kernel: a grid over weight (0, 500] and height (0, 300] in
+// `step` increments, ages 15..120 in `age-step` increments and every
+// Sex x Activity x Goal x Pace; then uniformly random weights and heights, which
+// also exercises the fixed-point input rounding. Reports the largest absolute
+// deviation of each output field, the input that produced it, and how many rows
+// would display differently once rounded (whole kcal, 0.1 g). Exits 1 if any
+// field drifts past half a display unit.
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "planner.h"
+#include "plan_grid.h"
+#include "plan_kernel.h"
+
+using namespace std;
+
+namespace {
+
+const size_t CHUNK_ROWS = 65536;
+
+enum Field { BMR, TDEE, TARGET, WEEKLY_KG, PROTEIN, FAT, CARBS, FIELD_COUNT };
+
+const char* FIELD_NAMES[FIELD_COUNT] = { "bmr", "tdee", "targetCalories", "weeklyChangeKg",
+                                         "protein_g", "fat_g", "carbs_g" };
+
+// Half of the unit each field is shown in: whole kcal, 0.1 g, 0.01 kg/week
+const double TOLERANCE[FIELD_COUNT] = { 0.5, 0.5, 0.5, 0.005, 0.05, 0.05, 0.05 };
+const double DISPLAY_UNIT[FIELD_COUNT] = { 1.0, 1.0, 1.0, 0.01, 0.1, 0.1, 0.1 };
+// computePlanFor may only differ from the table lookup by constant folding
+const double EXACT[FIELD_COUNT] = { 1e-9, 1e-9, 1e-9, 1e-12, 1e-9, 1e-9, 1e-9 };
+
+// computePlanFor instantiated for every table slot, indexed like PLAN_TABLE
+using PlanForFn = PlanResult (*)(double kg, double cm, int ageYears);
+
+template <size_t I>
+PlanResult planForSlot(double kg, double cm, int ageYears) {
+    constexpr size_t perSex = PLAN_ACTIVITIES * PLAN_GOALS * PLAN_PACES;
+    return computePlanFor<static_cast<Sex>(I / perSex),
+                          static_cast<Activity>(I / (PLAN_GOALS * PLAN_PACES) % PLAN_ACTIVITIES + 1),
+                          static_cast<Goal>(I / PLAN_PACES % PLAN_GOALS),
+                          static_cast<Pace>(I % PLAN_PACES)>(kg, cm, ageYears);
+}
+
+template <size_t... I>
+constexpr array<PlanForFn, sizeof...(I)> planForTable(index_sequence<I...>) {
+    return {{ &planForSlot<I>... }};
+}
+
+const array<PlanForFn, PLAN_TABLE_SIZE> PLAN_FOR = planForTable(make_index_sequence<PLAN_TABLE_SIZE>());
+
+// Rows of computePlanFor, shaped like a batch result for compare()
+struct PlanForRows {
+    const PlanBatchInput& in;
+    const vector<unsigned char>& status;   // validity comes from the batch
+
+    PlanResult row(size_t i) const {
+        size_t slot = planTableIndex(in.sex[i], in.activity[i], in.goal[i], in.pace[i]);
+        return PLAN_FOR[slot](in.weight[i], in.height[i], in.ageYears[i]);
+    }
+};
+
+struct Options {
+    double step       = 2.5;
+    double ageStep    = 5.0;
+    size_t samples    = 10000000;
+    unsigned seed     = 7;
+};
+
+struct Worst {
+    double    error = 0.0;
+    UserInput input = {};
+    double    expected = 0.0, actual = 0.0;
+};
+
+struct Report {
+    const char* kernel = "";
+    const double* tolerance = TOLERANCE;
+    size_t rows = 0;
+    Worst  worst[FIELD_COUNT];
+    size_t displayDiffs[FIELD_COUNT] = {};
+};
+
+void fields(const PlanResult& r, double out[FIELD_COUNT]) {
+    out[BMR]       = r.bmr;
+    out[TDEE]      = r.tdee;
+    out[TARGET]    = r.targetCalories;
+    out[WEEKLY_KG] = r.weeklyChangeKg;
+    out[PROTEIN]   = r.macros.protein_g;
+    out[FAT]       = r.macros.fat_g;
+    out[CARBS]     = r.macros.carbs_g;
+}
+
+UserInput rowInput(const PlanBatchInput& in, size_t i) {
+    UserInput u;
+    u.sex      = in.sex[i];
+    u.units    = Units::Metric;
+    u.ageYears = in.ageYears[i];
+    u.height   = in.height[i];
+    u.weight   = in.weight[i];
+    u.activity = in.activity[i];
+    u.goal     = in.goal[i];
+    u.pace     = in.pace[i];
+    return u;
+}
+
+template <class Result>
+void compare(const PlanBatchInput& in, const PlanBatchResult& ref, const Result& got, Report& report) {
+    double want[FIELD_COUNT], have[FIELD_COUNT];
+    for (size_t i = 0; i < in.size(); ++i) {
+        if (ref.status[i] != got.status[i]) {
+            fprintf(stderr, "%s: status mismatch at row %zu\n", report.kernel, i);
+            exit(1);
+        }
+        if (ref.status[i] != PLAN_OK) continue;
+        ++report.rows;
+        fields(ref.row(i), want);
+        fields(got.row(i), have);
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            double err = fabs(have[f] - want[f]);
+            if (err > report.worst[f].error) {
+                report.worst[f] = { err, rowInput(in, i), want[f], have[f] };
+            }
+            if (round(have[f] / DISPLAY_UNIT[f]) != round(want[f] / DISPLAY_UNIT[f])) ++report.displayDiffs[f];
+        }
+    }
+}
+
+struct Sweep {
+    Report f32, fixed, planFor;
+    PlanBatchResult      ref;
+    PlanBatchResultF32   outF32;
+    PlanBatchResultFixed outFixed;
+
+    Sweep() {
+        f32.kernel   = "float32";
+        fixed.kernel = "fixed";
+        planFor.kernel    = "computePlanFor";
+        planFor.tolerance = EXACT;
+    }
+
+    void run(const PlanBatchInput& in) {
+        computePlanBatch(in, ref);
+        computePlanBatchF32(in, outF32);
+        computePlanBatchFixed(in, outFixed);
+        compare(in, ref, outF32, f32);
+        compare(in, ref, outFixed, fixed);
+        compare(in, ref, PlanForRows{ in, ref.status }, planFor);
+    }
+};
+
+bool print(const char* sweep, const Report& r) {
+    bool ok = true;
+    printf("\n%s / %s: %zu valid rows\n", sweep, r.kernel, r.rows);
+    printf("  %-16s %12s %10s %12s  %s\n", "field", "max |err|", "tolerance", "display diff", "worst input (sex age cm kg act goal pace)");
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        const Worst& w = r.worst[f];
+        bool pass = w.error <= r.tolerance[f];
+        ok = ok && pass;
+        printf("  %-16s %12.3g %10g %12zu  %d %d %.4f %.4f %d %d %d  (%.6f vs %.6f)%s\n",
+               FIELD_NAMES[f], w.error, r.tolerance[f], r.displayDiffs[f],
+               int(w.input.sex), w.input.ageYears, w.input.height, w.input.weight,
+               int(w.input.activity), int(w.input.goal), int(w.input.pace),
+               w.expected, w.actual, pass ? "" : "  FAIL");
+    }
+    return ok;
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto value = [&](const char* prefix) { return arg.substr(char_traits<char>::length(prefix)); };
+        if (arg.rfind("--step=", 0) == 0)          opt.step = atof(value("--step=").c_str());
+        else if (arg.rfind("--age-step=", 0) == 0) opt.ageStep = atof(value("--age-step=").c_str());
+        else if (arg.rfind("--samples=", 0) == 0)  opt.samples = strtoull(value("--samples=").c_str(), nullptr, 10);
+        else if (arg.rfind("--seed=", 0) == 0)     opt.seed = unsigned(atoi(value("--seed=").c_str()));
+        else {
+            cerr << "usage: " << argv[0] << " [--step=cm/kg] [--age-step=years] [--samples=n] [--seed=n]" << endl;
+            exit(2);
+        }
+    }
+    if (!(opt.step > 0) || !(opt.ageStep >= 1)) {
+        cerr << "--step must be positive and --age-step at least 1" << endl;
+        exit(2);
+    }
+    return opt;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt = parseOptions(argc, argv);
+
+    PlanGrid grid;
+    grid.sexes      = { Sex::Male, Sex::Female };
+    grid.age        = { 15, 120, opt.ageStep };
+    grid.height     = { opt.step, 300, opt.step };
+    grid.weight     = { opt.step, 500, opt.step };
+    grid.activities = { Activity::Sedentary, Activity::Light, Activity::Moderate, Activity::Very, Activity::Extra };
+    grid.goals      = { Goal::Cut, Goal::Maintain, Goal::Bulk };
+    grid.paces      = { Pace::Slow, Pace::Normal, Pace::Aggressive };
+
+    PlanBatchInput in;
+    Sweep gridSweep;
+    const size_t gridRows = grid.size();
+    if (gridRows > MAX_GRID_ROWS) {
+        cerr << "grid exceeds " << MAX_GRID_ROWS << " rows; raise --step or --age-step" << endl;
+        return 2;
+    }
+    for (size_t first = 0; first < gridRows; first += CHUNK_ROWS) {
+        in.clear();
+        grid.fill(first, min(CHUNK_ROWS, gridRows - first), in);
+        gridSweep.run(in);
+    }
+
+    mt19937_64 rng(opt.seed);
+    uniform_int_distribution<int> age(15, 120), sex(0, 1), activity(1, 5), goal(0, 2), pace(0, 2);
+    uniform_real_distribution<double> height(0.0, 300.0), weight(0.0, 500.0);
+    Sweep randomSweep;
+    for (size_t done = 0; done < opt.samples; done += CHUNK_ROWS) {
+        in.clear();
+        for (size_t i = 0; i < min(CHUNK_ROWS, opt.samples - done); ++i) {
+            UserInput u;
+            u.sex      = static_cast<Sex>(sex(rng));
+            u.units    = Units::Metric;
+            u.ageYears = age(rng);
+            u.height   = 300.0 - height(rng);   // (0, 300]
+            u.weight   = 500.0 - weight(rng);   // (0, 500]
+            u.activity = static_cast<Activity>(activity(rng));
+            u.goal     = static_cast<Goal>(goal(rng));
+            u.pace     = static_cast<Pace>(pace(rng));
+            in.push_back(u);
+        }
+        randomSweep.run(in);
+    }
+
+    bool ok = true;
+    ok = print("grid", gridSweep.f32) && ok;
+    ok = print("grid", gridSweep.fixed) && ok;
+    ok = print("random", randomSweep.f32) && ok;
+    ok = print("random", randomSweep.fixed) && ok;
+    ok = print("grid", gridSweep.planFor) && ok;
+    ok = print("random", randomSweep.planFor) && ok;
+    printf("\n%s\n", ok ? "all fields within tolerance" : "tolerance exceeded");
+    return ok ? 0 : 1;
+}
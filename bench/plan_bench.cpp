@@ -0,0 +1,410 @@
+// plan_bench.cpp
+// Microbenchmarks for the planner, the HTTP JSON paths and USDA response parsing.
+//
+//   ./plan_bench [--filter=substr] [--min-time=0.5] [--fixtures=bench/fixtures]
+//                [--json=results.json] [--compare=baseline.json]
+//
+// Reports ns/op, heap allocations/op and throughput. --json writes the same
+// numbers in machine-readable form; --compare prints the change against a
+// previous --json run so regressions can be diffed between commits.
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "planner.h"
+#include "food_api.h"
+#include "api_json.h"
+#include "meal_solver.h"
+
+using namespace std;
+
+// --- allocation counting ---
+// Every global new in the process goes through these, so allocs/op covers
+// nlohmann::json, std::string and std::vector alike.
+
+// The malloc/free calls sit behind non-inlined helpers so the compiler never
+// pairs an inlined free() with a new-expression (-Wmismatched-new-delete).
+// Aligned blocks keep the malloc'd base just before the pointer handed out.
+
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE
+#endif
+
+namespace {
+    atomic<size_t> g_allocs{0};
+    atomic<size_t> g_allocBytes{0};
+
+    BENCH_NOINLINE void* countedAlloc(size_t size, size_t align) noexcept {
+        g_allocs.fetch_add(1, memory_order_relaxed);
+        g_allocBytes.fetch_add(size, memory_order_relaxed);
+        if (align <= alignof(max_align_t)) return malloc(size ? size : 1);
+        void* base = malloc(size + align + sizeof(void*));
+        if (!base) return nullptr;
+        uintptr_t p = (reinterpret_cast<uintptr_t>(base) + sizeof(void*) + align - 1) & ~(uintptr_t(align) - 1);
+        reinterpret_cast<void**>(p)[-1] = base;
+        return reinterpret_cast<void*>(p);
+    }
+    BENCH_NOINLINE void countedFree(void* p, size_t align) noexcept {
+        if (p && align > alignof(max_align_t)) p = static_cast<void**>(p)[-1];
+        free(p);
+    }
+    void* countedNew(size_t size, size_t align) {
+        if (void* p = countedAlloc(size, align)) return p;
+        throw bad_alloc();
+    }
+    const size_t PLAIN = alignof(max_align_t);
+}
+
+void* operator new(size_t size) { return countedNew(size, PLAIN); }
+void* operator new[](size_t size) { return countedNew(size, PLAIN); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return countedAlloc(size, PLAIN); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return countedAlloc(size, PLAIN); }
+void* operator new(size_t size, align_val_t a) { return countedNew(size, size_t(a)); }
+void* operator new[](size_t size, align_val_t a) { return countedNew(size, size_t(a)); }
+void* operator new(size_t size, align_val_t a, const nothrow_t&) noexcept { return countedAlloc(size, size_t(a)); }
+void* operator new[](size_t size, align_val_t a, const nothrow_t&) noexcept { return countedAlloc(size, size_t(a)); }
+
+void operator delete(void* p) noexcept { countedFree(p, PLAIN); }
+void operator delete[](void* p) noexcept { countedFree(p, PLAIN); }
+void operator delete(void* p, size_t) noexcept { countedFree(p, PLAIN); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p, PLAIN); }
+void operator delete(void* p, const nothrow_t&) noexcept { countedFree(p, PLAIN); }
+void operator delete[](void* p, const nothrow_t&) noexcept { countedFree(p, PLAIN); }
+void operator delete(void* p, align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete[](void* p, align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete(void* p, size_t, align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete[](void* p, size_t, align_val_t a) noexcept { countedFree(p, size_t(a)); }
+void operator delete(void* p, align_val_t a, const nothrow_t&) noexcept { countedFree(p, size_t(a)); }
+void operator delete[](void* p, align_val_t a, const nothrow_t&) noexcept { countedFree(p, size_t(a)); }
+
+namespace {
+
+// Keeps the optimizer from discarding a result we never read.
+template <class T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct BenchResult {
+    string name;
+    size_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesAllocPerOp;
+    double itemsPerOp;   // users planned, foods parsed, ...
+    double bytesPerOp;   // input bytes processed, 0 if not meaningful
+};
+
+struct Options {
+    string filter;
+    double minTime = 0.5;
+    string fixtures = "bench/fixtures";
+    string jsonPath;
+    string comparePath;
+};
+
+// Runs op in growing batches until minTime has elapsed, then reports per-op figures.
+BenchResult runBench(const string& name, const Options& opt, double itemsPerOp, double bytesPerOp,
+                     const function<void()>& op) {
+    using clock = chrono::steady_clock;
+    for (int i = 0; i < 3; ++i) op();   // warm caches and lazy allocations
+
+    size_t iterations = 1;
+    for (;;) {
+        size_t allocs0 = g_allocs.load(), bytes0 = g_allocBytes.load();
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; ++i) op();
+        double secs = chrono::duration<double>(clock::now() - start).count();
+        size_t allocs = g_allocs.load() - allocs0, bytes = g_allocBytes.load() - bytes0;
+
+        if (secs >= opt.minTime || iterations >= (size_t(1) << 30)) {
+            BenchResult r;
+            r.name            = name;
+            r.iterations      = iterations;
+            r.nsPerOp         = secs * 1e9 / iterations;
+            r.allocsPerOp     = double(allocs) / iterations;
+            r.bytesAllocPerOp = double(bytes) / iterations;
+            r.itemsPerOp      = itemsPerOp;
+            r.bytesPerOp      = bytesPerOp;
+            return r;
+        }
+        // Aim a little past minTime on the next pass
+        double scale = secs > 0 ? (opt.minTime * 1.2) / secs : 100.0;
+        iterations = max(iterations * 2, size_t(iterations * min(scale, 100.0)));
+    }
+}
+
+// --- inputs ---
+
+vector<UserInput> randomPopulation(size_t n, unsigned seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> age(15, 120), sex(0, 1), activity(1, 5), goal(0, 2), pace(0, 2);
+    uniform_real_distribution<double> height(140.0, 210.0), weight(40.0, 180.0), bodyFat(8.0, 45.0);
+
+    vector<UserInput> users(n);
+    for (auto& u : users) {
+        u.sex      = static_cast<Sex>(sex(rng));
+        u.units    = Units::Metric;
+        u.ageYears = age(rng);
+        u.height   = height(rng);
+        u.weight   = weight(rng);
+        u.activity = static_cast<Activity>(activity(rng));
+        u.goal     = static_cast<Goal>(goal(rng));
+        u.pace     = static_cast<Pace>(pace(rng));
+        u.bodyFatPct = bodyFat(rng);
+    }
+    return users;
+}
+
+// Candidate foods with random but self-consistent macros (kcal = 4p + 9f + 4c per 100 g)
+vector<FoodItem> randomFoods(size_t n, unsigned seed) {
+    mt19937 rng(seed);
+    uniform_real_distribution<double> protein(0.0, 30.0), fat(0.0, 40.0), carbs(0.0, 80.0);
+    vector<FoodItem> foods(n);
+    for (size_t i = 0; i < n; ++i) {
+        FoodItem& f = foods[i];
+        f.fdcId     = int(100000 + i);
+        f.protein_g = protein(rng);
+        f.fat_g     = fat(rng);
+        f.carbs_g   = carbs(rng);
+        f.calories  = 4 * f.protein_g + 9 * f.fat_g + 4 * f.carbs_g;
+    }
+    return foods;
+}
+
+string planRequestBody(const UserInput& u) {
+    json body;
+    body["sex"]       = sexName(u.sex);
+    body["age"]       = u.ageYears;
+    body["height_cm"] = u.height;
+    body["weight_kg"] = u.weight;
+    body["activity"]  = activityName(u.activity);
+    body["goal"]      = goalName(u.goal);
+    body["pace"]      = paceName(u.pace);
+    return body.dump();
+}
+
+bool readFile(const string& path, string& out) {
+    ifstream file(path, ios::binary);
+    if (!file) return false;
+    ostringstream ss;
+    ss << file.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+// --- reporting ---
+
+void printResult(const BenchResult& r) {
+    double opsPerSec = 1e9 / r.nsPerOp;
+    printf("%-34s %12.1f ns/op %9.2f allocs/op %11.0f B/op %14.0f items/s",
+           r.name.c_str(), r.nsPerOp, r.allocsPerOp, r.bytesAllocPerOp, opsPerSec * r.itemsPerOp);
+    if (r.bytesPerOp > 0) printf(" %9.1f MB/s", opsPerSec * r.bytesPerOp / 1e6);
+    printf("\n");
+}
+
+json resultToJson(const BenchResult& r) {
+    double opsPerSec = 1e9 / r.nsPerOp;
+    json j;
+    j["name"]                   = r.name;
+    j["iterations"]             = r.iterations;
+    j["ns_per_op"]              = r.nsPerOp;
+    j["allocs_per_op"]          = r.allocsPerOp;
+    j["bytes_allocated_per_op"] = r.bytesAllocPerOp;
+    j["items_per_op"]           = r.itemsPerOp;
+    j["items_per_sec"]          = opsPerSec * r.itemsPerOp;
+    j["mb_per_sec"]             = opsPerSec * r.bytesPerOp / 1e6;
+    return j;
+}
+
+void printComparison(const vector<BenchResult>& results, const string& path) {
+    string text;
+    if (!readFile(path, text)) {
+        cerr << "cannot read " << path << endl;
+        return;
+    }
+    json baseline = json::parse(text, nullptr, false);
+    if (baseline.is_discarded() || !baseline.contains("results")) {
+        cerr << path << " is not a plan_bench --json file" << endl;
+        return;
+    }
+
+    printf("\n%-34s %12s %12s %9s %12s\n", "vs baseline", "old ns/op", "new ns/op", "delta", "allocs delta");
+    for (const auto& r : results) {
+        for (const auto& old : baseline["results"]) {
+            if (old.value("name", "") != r.name) continue;
+            double oldNs = old.value("ns_per_op", 0.0);
+            double oldAllocs = old.value("allocs_per_op", 0.0);
+            printf("%-34s %12.1f %12.1f %+8.1f%% %+12.2f\n", r.name.c_str(), oldNs, r.nsPerOp,
+                   oldNs > 0 ? (r.nsPerOp - oldNs) / oldNs * 100.0 : 0.0, r.allocsPerOp - oldAllocs);
+        }
+    }
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto value = [&](const char* prefix) { return arg.substr(char_traits<char>::length(prefix)); };
+        if (arg.rfind("--filter=", 0) == 0)        opt.filter = value("--filter=");
+        else if (arg.rfind("--min-time=", 0) == 0) opt.minTime = atof(value("--min-time=").c_str());
+        else if (arg.rfind("--fixtures=", 0) == 0) opt.fixtures = value("--fixtures=");
+        else if (arg.rfind("--json=", 0) == 0)     opt.jsonPath = value("--json=");
+        else if (arg.rfind("--compare=", 0) == 0)  opt.comparePath = value("--compare=");
+        else {
+            cerr << "usage: " << argv[0]
+                 << " [--filter=substr] [--min-time=sec] [--fixtures=dir] [--json=out] [--compare=baseline]" << endl;
+            exit(2);
+        }
+    }
+    return opt;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt = parseOptions(argc, argv);
+    vector<BenchResult> results;
+
+    auto bench = [&](const string& name, double itemsPerOp, double bytesPerOp, const function<void()>& op) {
+        if (!opt.filter.empty() && name.find(opt.filter) == string::npos) return;
+        results.push_back(runBench(name, opt, itemsPerOp, bytesPerOp, op));
+        printResult(results.back());
+    };
+
+    // --- planner ---
+    const size_t POPULATION = 4096;
+    vector<UserInput> users = randomPopulation(POPULATION, 385);
+
+    bench("planner/computePlan", POPULATION, 0, [&] {
+        for (const auto& u : users) doNotOptimize(computePlan(u));
+    });
+
+    bench("planner/tryComputePlan", POPULATION, 0, [&] {
+        for (const auto& u : users) doNotOptimize(tryComputePlan(u));
+    });
+
+    PlanBatchInput batchIn;
+    for (const auto& u : users) batchIn.push_back(u);
+    PlanBatchResult batchOut;
+    bench("planner/computePlanBatch", POPULATION, 0, [&] {
+        computePlanBatch(batchIn, batchOut);
+        doNotOptimize(batchOut.targetCalories[0]);
+    });
+
+    PlanBatchResultF32 batchOutF32;
+    bench("planner/computePlanBatchF32", POPULATION, 0, [&] {
+        computePlanBatchF32(batchIn, batchOutF32);
+        doNotOptimize(batchOutF32.targetCalories[0]);
+    });
+
+    PlanBatchResultFixed batchOutFixed;
+    bench("planner/computePlanBatchFixed", POPULATION, 0, [&] {
+        computePlanBatchFixed(batchIn, batchOutFixed);
+        doNotOptimize(batchOutFixed.targetCalories[0]);
+    });
+
+    BmrComparison comparison;
+    bench("planner/compareBmrFormulas", POPULATION, 0, [&] {
+        compareBmrFormulas(batchIn, comparison);
+        doNotOptimize(comparison.targetCalories[0][0]);
+    });
+
+    bench("planner/tryComputePlan_each_formula", POPULATION, 0, [&] {
+        for (const auto& u : users)
+            for (size_t f = 0; f < BMR_FORMULA_COUNT; ++f)
+                doNotOptimize(tryComputePlan(u, static_cast<BmrFormula>(f)));
+    });
+
+    bench("planner/simulateTrajectory_52w", 53, 0, [&] {
+        doNotOptimize(simulateTrajectory(users[0], 52, users[0].weight * 0.9));
+    });
+
+    // --- macro-target meal solver ---
+    NutrientMatrix matrix;
+    matrix.assign(randomFoods(3000, 9));
+    const MacroPlan dayTarget = macroTargets(2400, 180);
+    bench("solver/solveMeal_3000_foods", 1, 0, [&] {
+        doNotOptimize(solveMeal(matrix, dayTarget));
+    });
+
+    // --- /plan request parse + response serialize ---
+    vector<string> bodies;
+    size_t bodyBytes = 0;
+    for (size_t i = 0; i < 256; ++i) {
+        bodies.push_back(planRequestBody(users[i]));
+        bodyBytes += bodies.back().size();
+    }
+    bench("http/plan_roundtrip", bodies.size(), double(bodyBytes), [&] {
+        for (const auto& text : bodies) {
+            json body = json::parse(text, nullptr, false);
+            UserInput u;
+            string error;
+            if (!parseUserInput(body, u, error)) abort();
+            PlanOutcome plan = tryComputePlan(u);
+            string out = planToJson(plan.result).dump();
+            doNotOptimize(out);
+        }
+    });
+
+    // --- /api/recommend-foods response assembly ---
+    FoodRecommendations recs;
+    recs.goal_type = "cut";
+    const char* names[] = {"Chicken, broilers or fryers, breast, meat only, cooked, roasted",
+                           "Egg, white, raw, fresh", "Yogurt, Greek, plain, nonfat",
+                           "Fish, tilapia, cooked, dry heat", "Fish, cod, Atlantic, cooked, dry heat"};
+    auto table = make_shared<FoodTable>();
+    for (int i = 0; i < 5; ++i) {
+        recs.rows.push_back(uint32_t(table->add({171077 + i, names[i], 100.0 + i * 20, 20.0 + i, 1.5 * i, 2.0 + i, {}})));
+        recs.grams.push_back(250.0 - i * 40);
+    }
+    recs.table = table;
+    bench("http/recommend_foods_serialize", recs.rows.size(), 0, [&] {
+        string out = recommendationsToJson(recs).dump();
+        doNotOptimize(out);
+    });
+
+    // --- USDA /foods/search parsing against recorded fixtures ---
+    for (const char* fixture : {"search_chicken_breast.json", "search_oats.json"}) {
+        string text;
+        if (!readFile(opt.fixtures + "/" + fixture, text)) {
+            cerr << "skipping " << fixture << ": not found under " << opt.fixtures << endl;
+            continue;
+        }
+        size_t foods = parseFoodSearchResponse(text, 1000).size();
+        bench(string("usda/parse/") + fixture, double(foods), double(text.size()), [&] {
+            doNotOptimize(parseFoodSearchResponse(text, 1000));
+        });
+    }
+
+    if (!opt.jsonPath.empty()) {
+        json report;
+        report["results"] = json::array();
+        for (const auto& r : results) report["results"].push_back(resultToJson(r));
+        ofstream(opt.jsonPath) << report.dump(2) << "\n";
+    }
+    if (!opt.comparePath.empty()) printComparison(results, opt.comparePath);
+    return 0;
+}
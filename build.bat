@@ -1,8 +1,8 @@
 @echo off
 cd /d "%~dp0"
 set GCC=C:\msys64\mingw64\bin\g++.exe
-echo Compiling server.cpp and healthtracker.cpp...
-"%GCC%" -o server.exe server.cpp healthtracker.cpp -std=c++17 -pthread -D_WIN32_WINNT=0x0A00 -lws2_32 > build_log.txt 2>&1
+echo Compiling server sources...
+"%GCC%" -O2 -o server.exe server.cpp healthtracker.cpp api_json.cpp food_api.cpp usda_parse.cpp usda_quota.cpp usda_client.cpp food_table.cpp goal_foods.cpp food_cache.cpp food_disk_cache.cpp food_suggest.cpp food_fuzzy.cpp food_index.cpp food_store.cpp http_pool.cpp meal_plan.cpp meal_solver.cpp plan_bmr.cpp plan_lowp.cpp plan_grid.cpp plan_trajectory.cpp -std=c++17 -pthread -D_WIN32_WINNT=0x0A00 -lcurl -lws2_32 > build_log.txt 2>&1
 set BUILD_EXIT=%ERRORLEVEL%
 type build_log.txt
 if %BUILD_EXIT% NEQ 0 (
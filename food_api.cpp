@@ -1,112 +1,192 @@
 #include "food_api.h"
+#include "food_cache.h"
+#include "food_store.h"
+#include "goal_foods.h"
+#include "http_pool.h"
+#include "meal_solver.h"
+#include "usda_client.h"
 #include "json.hpp"
-#include <curl/curl.h>
+#include <chrono>
 #include <iostream>
 #include <sstream>
-#include "config.h"
+#include <unordered_map>
 
 using json = nlohmann::json;
 using namespace std;
 
-// Callback function for cURL to write response data
-size_t WriteCallback(void* contents, size_t size, size_t nmemb, string* userp) {
-    userp->append((char*)contents, size * nmemb);
-    return size * nmemb;
+const string USDA_API_BASE = "https://api.nal.usda.gov/fdc/v1/";
+
+void prewarmFoodApi(int connections) {
+    prewarmHttpPool(USDA_API_BASE, connections);
 }
 
-// Make HTTP GET request
-string httpGet(const string& url) {
-    CURL* curl;
-    CURLcode res;
-    string readBuffer;
-
-    curl = curl_easy_init();
-    if(curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L); // For Windows SSL issues
-        
-        res = curl_easy_perform(curl);
-        
-        if(res != CURLE_OK) {
-            cerr << "cURL error: " << curl_easy_strerror(res) << endl;
-        }
-        
-        curl_easy_cleanup(curl);
+// The api_key is added by usda_client, from whichever key has quota left
+string searchUrl(const string& query, int maxResults) {
+    return USDA_API_BASE + "foods/search?query=" + urlEncode(query)
+           + "&pageSize=" + to_string(maxResults);
+}
+
+namespace {
+    string failureText(const HttpResponse& r) {
+        return r.ok ? "HTTP " + to_string(r.status) : r.error;
+    }
+
+    // What to answer when USDA could not: the query's expired results if the
+    // cache still has them, else nothing
+    FoodTable fallback(FoodSearchCache& cache, const string& key, const string& query, const HttpResponse& r) {
+        FoodSearchCache::Value old = cache.stale(key);
+        cerr << "search '" << query << "' failed (" << failureText(r) << ")"
+             << (old ? "; serving stale results" : "") << endl;
+        return old ? *old : FoodTable();
     }
-    return readBuffer;
 }
 
-// Search for foods in USDA database
+// Search for foods in USDA database. Network results go through the search
+// cache. A failed request (error, timeout, 5xx, or USDA's circuit breaker
+// open) falls back to stale results; neither those nor empty ones are cached.
+shared_ptr<const FoodTable> searchFoodTable(const string& query, int maxResults) {
+    if (const FoodStore* store = localFoodStore()) return make_shared<const FoodTable>(store->searchTable(query, maxResults));
+
+    FoodSearchCache& cache = foodSearchCache();
+    const string key = FoodSearchCache::key(query, maxResults);
+    return cache.getOrLoad(key, [&](FoodTable& out) {
+        HttpResponse response = usdaGet(searchUrl(query, maxResults));
+        if (!usdaAnswered(response)) {
+            out = fallback(cache, key, query, response);
+            return false;
+        }
+        out = parseFoodSearchResponse(response.body, maxResults);
+        return !out.empty();
+    });
+}
+
 vector<FoodItem> searchFoods(const string& query, int maxResults) {
-    vector<FoodItem> results;
-    
-    // URL encode the query
-    CURL* curl = curl_easy_init();
-    char* encoded = curl_easy_escape(curl, query.c_str(), query.length());
-    string encodedQuery(encoded);
-    curl_free(encoded);
-    curl_easy_cleanup(curl);
-    
-    // Build API URL
-    string url = "https://api.nal.usda.gov/fdc/v1/foods/search?query=" + encodedQuery 
-                 + "&pageSize=" + to_string(maxResults)
-                 + "&api_key=" + USDA_API_KEY;
-    
-    // Make request
-    string response = httpGet(url);
-    
-    try {
-        auto jsonResponse = json::parse(response);
-        
-        if (jsonResponse.contains("foods")) {
-            for (const auto& food : jsonResponse["foods"]) {
-                FoodItem item;
-                item.fdcId = food.value("fdcId", 0);
-                item.description = food.value("description", "Unknown");
-                
-                // Initialize to 0
-                item.calories = 0;
-                item.protein_g = 0;
-                item.carbs_g = 0;
-                item.fat_g = 0;
-                
-                // Extract nutrients
-                if (food.contains("foodNutrients")) {
-                    for (const auto& nutrient : food["foodNutrients"]) {
-                        string name = nutrient.value("nutrientName", "");
-                        double value = nutrient.value("value", 0.0);
-                        
-                        if (name == "Energy" || name.find("Energy") != string::npos) {
-                            item.calories = value;
-                        } else if (name == "Protein") {
-                            item.protein_g = value;
-                        } else if (name.find("Carbohydrate") != string::npos) {
-                            item.carbs_g = value;
-                        } else if (name.find("Total lipid") != string::npos || name == "Fat") {
-                            item.fat_g = value;
-                        }
-                    }
-                }
-                
-                results.push_back(item);
-                
-                if (results.size() >= maxResults) break;
-            }
+    return searchFoodTable(query, maxResults)->items();
+}
+
+vector<shared_ptr<const FoodTable>> searchFoodsConcurrent(const vector<string>& queries, int maxResults,
+                                                          int perRequestMs, int totalMs, UsdaPriority priority) {
+    if (const FoodStore* store = localFoodStore()) {
+        vector<shared_ptr<const FoodTable>> results;
+        for (const auto& query : queries) results.push_back(make_shared<const FoodTable>(store->searchTable(query, maxResults)));
+        return results;
+    }
+
+    // Cached queries are answered now, ones another thread is already fetching
+    // are waited on below, and only the rest go out
+    const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(totalMs);
+    FoodSearchCache& cache = foodSearchCache();
+    const auto none = make_shared<const FoodTable>();
+    vector<shared_ptr<const FoodTable>> results(queries.size(), none);
+    vector<FoodSearchCache::Lookup> lookups(queries.size());
+    vector<string> keys, urls;
+    vector<size_t> fetched;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        keys.push_back(FoodSearchCache::key(queries[i], maxResults));
+        lookups[i] = cache.begin(keys[i]);
+        if (lookups[i].value) {
+            results[i] = lookups[i].value;
+        } else if (lookups[i].leader) {
+            urls.push_back(searchUrl(queries[i], maxResults));
+            fetched.push_back(i);
         }
-    } catch (const exception& e) {
-        cerr << "JSON parsing error: " << e.what() << endl;
     }
-    
+
+    vector<HttpResponse> responses = usdaGetAll(urls, perRequestMs, totalMs, priority);
+    for (size_t r = 0; r < responses.size(); ++r) {
+        const size_t i = fetched[r];
+        if (!usdaAnswered(responses[r])) {
+            results[i] = cache.finish(keys[i], fallback(cache, keys[i], queries[i], responses[r]), false);
+            continue;
+        }
+        FoodTable foods = parseFoodSearchResponse(responses[r].body, maxResults);
+        bool cacheable = !foods.empty();
+        results[i] = cache.finish(keys[i], move(foods), cacheable);
+    }
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto& pending = lookups[i].pending;
+        if (!pending.valid()) continue;
+        if (pending.wait_until(deadline) == future_status::ready) results[i] = pending.get();
+        else cerr << "search '" << queries[i] << "' dropped: deadline exceeded" << endl;
+    }
     return results;
 }
 
-// Recommend foods based on goals
-FoodRecommendations recommendFoods(const string& goal, double targetProtein, double targetCalories) {
-    FoodRecommendations recommendations;
-    recommendations.goal_type = goal;
-    
+FoodTable getFoods(const int* fdcIds, size_t count, UsdaPriority priority) {
+    if (const FoodStore* store = localFoodStore()) {
+        vector<size_t> rows;
+        for (size_t i = 0; i < count; ++i) {
+            long row = store->find(fdcIds[i]);
+            if (row >= 0) rows.push_back(size_t(row));
+        }
+        return store->table(rows);
+    }
+
+    // Each distinct id is looked up once: cached ones are answered now, ones
+    // another thread is fetching are waited on below, and the rest go out in
+    // batches of FOODS_PER_REQUEST, every batch in flight at once
+    const size_t FOODS_PER_REQUEST = 20;
+    const int PER_REQUEST_MS = 4000, TOTAL_MS = 6000;
+    const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(TOTAL_MS);
+    FoodSearchCache& cache = foodSearchCache();
+    unordered_map<int, FoodSearchCache::Value> found;
+    unordered_map<int, FoodSearchCache::Lookup> waiting;
+    vector<int> fetch;
+    for (size_t i = 0; i < count; ++i) {
+        const int id = fdcIds[i];
+        if (!found.emplace(id, nullptr).second) continue;
+        FoodSearchCache::Lookup lookup = cache.begin(FoodSearchCache::foodKey(id));
+        if (lookup.value) found[id] = lookup.value;
+        else if (lookup.leader) fetch.push_back(id);
+        else waiting[id] = move(lookup);
+    }
+
+    vector<string> urls;
+    for (size_t b = 0; b < fetch.size(); b += FOODS_PER_REQUEST) {
+        string ids;
+        for (size_t i = b; i < min(fetch.size(), b + FOODS_PER_REQUEST); ++i) ids += (ids.empty() ? "" : ",") + to_string(fetch[i]);
+        urls.push_back(USDA_API_BASE + "foods?format=full&fdcIds=" + ids);
+    }
+
+    vector<HttpResponse> responses = usdaGetAll(urls, PER_REQUEST_MS, TOTAL_MS, priority);
+    for (size_t r = 0; r < responses.size(); ++r) {
+        const bool answered = usdaAnswered(responses[r]);
+        FoodTable foods;
+        if (answered) foods = parseFoodListResponse(responses[r].body);
+        else cerr << "foods batch " << r << " failed (" << failureText(responses[r]) << "); serving stale entries" << endl;
+
+        unordered_map<int, size_t> rowOf;
+        for (size_t i = 0; i < foods.size(); ++i) rowOf.emplace(foods.fdcId(i), i);
+        for (size_t i = r * FOODS_PER_REQUEST; i < min(fetch.size(), (r + 1) * FOODS_PER_REQUEST); ++i) {
+            const int id = fetch[i];
+            const string key = FoodSearchCache::foodKey(id);
+            FoodTable one;
+            auto row = rowOf.find(id);
+            if (row != rowOf.end()) one.add(foods[row->second]);
+            else if (auto old = answered ? nullptr : cache.stale(key)) one = *old;
+            const bool cacheable = row != rowOf.end();
+            found[id] = cache.finish(key, move(one), cacheable);
+        }
+    }
+
+    for (auto& w : waiting) {
+        auto& pending = w.second.pending;
+        if (pending.wait_until(deadline) == future_status::ready) found[w.first] = pending.get();
+        else cerr << "food " << w.first << " dropped: deadline exceeded" << endl;
+    }
+
+    FoodTable out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const FoodSearchCache::Value& food = found[fdcIds[i]];
+        if (food && !food->empty()) out.add((*food)[0]);
+    }
+    return out;
+}
+
+// Search pool for a goal
+FoodTable candidateFoods(const string& goal, vector<uint32_t>* firstHits, UsdaPriority priority) {
     vector<string> searchTerms;
     
     if (goal == "cut") {
@@ -120,13 +200,45 @@ FoodRecommendations recommendFoods(const string& goal, double targetProtein, dou
         searchTerms = {"brown rice", "chicken", "broccoli", "sweet potato", "almonds"};
     }
     
-    // Search for each term and take the best result
-    for (const auto& term : searchTerms) {
-        auto foods = searchFoods(term, 1);
-        if (!foods.empty()) {
-            recommendations.foods.push_back(foods[0]);
+    // All terms in flight at once; a term that times out just contributes nothing
+    const int CANDIDATES_PER_TERM = 50;
+    // Background refreshes can afford to queue behind searches for quota
+    const int batchMs = priority == USDA_BACKGROUND ? 60000 : 6000;
+    FoodTable candidates;
+    unordered_map<int, uint32_t> rowOf;   // fdcId -> candidate row
+    for (const auto& foods : searchFoodsConcurrent(searchTerms, CANDIDATES_PER_TERM, 4000, batchMs, priority)) {
+        for (size_t i = 0; i < foods->size(); ++i) {
+            auto slot = rowOf.emplace(foods->fdcId(i), uint32_t(candidates.size()));
+            if (slot.second) candidates.add((*foods)[i]);
+            if (firstHits && i == 0) firstHits->push_back(slot.first->second);
         }
     }
-    
+    return candidates;
+}
+
+FoodRecommendations recommendFoods(const string& goal, double targetProtein, double targetCalories) {
+    FoodRecommendations recommendations;
+    recommendations.goal_type = goal;
+
+    // Let the solver pick foods and portions from the candidate pool that hit the
+    // targets. Without usable targets, fall back to the best result per term.
+    // The pool is the prefetched one, so this does no upstream I/O once warm.
+    // The rows index the pool's table, which the recommendations keep alive.
+    shared_ptr<const GoalFoods> pool = goalFoods(goal);
+    recommendations.table = shared_ptr<const FoodTable>(pool, &pool->foods);
+
+    if (targetCalories > 0 && !pool->foods.empty()) {
+        MealSolution meal = solveMeal(pool->matrix, macroTargets(targetCalories, targetProtein));
+        if (!meal.portions.empty()) {
+            for (const auto& p : meal.portions) {
+                recommendations.rows.push_back(uint32_t(p.food));
+                recommendations.grams.push_back(p.grams);
+            }
+            recommendations.withinTolerance = meal.withinTolerance;
+            return recommendations;
+        }
+    }
+
+    recommendations.rows = pool->firstHits;
     return recommendations;
-}
\ No newline at end of file
+}
@@ -1,8 +1,12 @@
 #ifndef FOOD_API_H
 #define FOOD_API_H
 
+#include <memory>
 #include <string>
 #include <vector>
+#include "food_table.h"
+#include "nutrients.h"
+#include "usda_quota.h"
 
 struct FoodItem {
     int fdcId;
@@ -11,16 +15,67 @@ struct FoodItem {
     double protein_g;
     double carbs_g;
     double fat_g;
+    NutrientVector nutrients;   // per 100 g, macros included; see nutrients.h
+
+    // Fills the vector and the named macro fields from per-slot amounts
+    void setNutrients(const double (&amount)[NUTRIENT_COUNT]) {
+        for (int n = 0; n < NUTRIENT_COUNT; ++n) nutrients.value[n] = float(amount[n]);
+        calories  = amount[NUTRIENT_KCAL];
+        protein_g = amount[NUTRIENT_PROTEIN];
+        carbs_g   = amount[NUTRIENT_CARBS];
+        fat_g     = amount[NUTRIENT_FAT];
+    }
 };
 
 struct FoodRecommendations {
-    std::vector<FoodItem> foods;
+    std::shared_ptr<const FoodTable> table;   // the candidate pool the rows index
+    std::vector<uint32_t> rows;
     std::string goal_type; // "cut", "bulk", or "maintain"
+    std::vector<double> grams;     // portion per row when the macro solver ran, else empty
+    bool withinTolerance = false;  // solver hit every macro target within its tolerance
+
+    FoodRows foods() const { return table ? FoodRows(*table, rows.data(), rows.size()) : FoodRows(); }
 };
 
-// Search USDA database
+// Opens keep-alive connections to the USDA API ahead of the first search.
+// Blocks; call from a background thread at startup.
+void prewarmFoodApi(int connections = 4);
+
+// Search USDA database; served from the local food store when one is open
+// (see food_store.h), otherwise over the network. Cached results are shared,
+// never copied; searchFoods unpacks them into rows.
+std::shared_ptr<const FoodTable> searchFoodTable(const std::string& query, int maxResults = 5);
 std::vector<FoodItem> searchFoods(const std::string& query, int maxResults = 5);
 
+// One search per query, all in flight at once. Each is capped at perRequestMs and
+// the batch at totalMs, queueing for USDA quota included; a query that fails or
+// misses its deadline yields an empty table. Results line up with queries and
+// are never null.
+std::vector<std::shared_ptr<const FoodTable>> searchFoodsConcurrent(const std::vector<std::string>& queries,
+                                                                    int maxResults, int perRequestMs = 4000,
+                                                                    int totalMs = 6000,
+                                                                    UsdaPriority priority = USDA_INTERACTIVE);
+
+// Parse a /foods/search response body, or a /foods (list of fdcIds) one
+// (implemented in usda_parse.cpp)
+FoodTable parseFoodSearchResponse(const std::string& response, int maxResults);
+FoodTable parseFoodListResponse(const std::string& response);
+
+// Full nutrient data for known fdcIds, one row per id that USDA (or the local
+// store) has, in input order; unknown ids are left out. Ids already cached are
+// answered from the food search cache. The rest go out 20 to a request (the
+// most USDA's /foods endpoint takes), all batches at once, and each food is
+// cached under its id. C++17 has no std::span; pass a pointer and a count.
+FoodTable getFoods(const int* fdcIds, size_t count, UsdaPriority priority = USDA_INTERACTIVE);
+inline FoodTable getFoods(const std::vector<int>& fdcIds, UsdaPriority priority = USDA_INTERACTIVE) {
+    return getFoods(fdcIds.data(), fdcIds.size(), priority);
+}
+
+// Deduplicated search results for the goal's search terms, in term order.
+// firstHits, if given, receives the row of each term's top result.
+FoodTable candidateFoods(const std::string& goal, std::vector<uint32_t>* firstHits = nullptr,
+                         UsdaPriority priority = USDA_INTERACTIVE);
+
 // Get food recommendations based on goals
 FoodRecommendations recommendFoods(const std::string& goal, double targetProtein, double targetCalories);
 
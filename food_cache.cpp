@@ -0,0 +1,262 @@
+// food_cache.cpp
+#include "food_cache.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+namespace {
+    const size_t   SKETCH_WIDTH = 2048;               // counters per row, a power of two
+    const unsigned SKETCH_ROWS  = 4;
+    const uint32_t SKETCH_RESET = 10 * SKETCH_WIDTH;  // samples between halvings
+
+    size_t sketchSlot(size_t hash, unsigned row) {
+        uint64_t x = uint64_t(hash) + row * 0x9E3779B97F4A7C15ull;
+        x ^= x >> 31;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 29;
+        return row * SKETCH_WIDTH + size_t(x & (SKETCH_WIDTH - 1));
+    }
+
+    unsigned counterAt(const vector<uint8_t>& sketch, size_t slot) {
+        return (sketch[slot / 2] >> (slot % 2 * 4)) & 0xf;
+    }
+
+    size_t entryBytes(const string& key, const FoodTable& foods) {
+        // key in the map and the entry, node overhead
+        return 2 * key.size() + 128 + sizeof(FoodTable) + foods.bytes();
+    }
+}
+
+FoodSearchCache::FoodSearchCache(size_t capacityBytes, chrono::seconds ttl)
+    : shardBytes(capacityBytes / FOOD_CACHE_SHARDS), ttl(ttl), shards(new Shard[FOOD_CACHE_SHARDS]) {
+    for (size_t i = 0; i < FOOD_CACHE_SHARDS; ++i) shards[i].sketch.assign(SKETCH_ROWS * SKETCH_WIDTH / 2, 0);
+}
+
+// Lowercased words joined by single spaces, then the result count:
+// "Chicken  Breast" and "chicken, breast" share an entry. Bytes of multi-byte
+// UTF-8 characters are word bytes kept as they are, so "豆腐" and "寿司" differ;
+// only ASCII is lowercased.
+string FoodSearchCache::key(const string& query, int maxResults) {
+    string k;
+    bool gap = false;
+    for (unsigned char c : query) {
+        if (c >= 0x80 || isalnum(c)) {
+            if (gap && !k.empty()) k += ' ';
+            k += c >= 0x80 ? char(c) : char(tolower(c));
+            gap = false;
+        } else {
+            gap = true;
+        }
+    }
+    return k + '#' + to_string(maxResults);
+}
+
+// Search keys are alphanumerics, spaces and '#', so ':' keeps these apart
+string FoodSearchCache::foodKey(int fdcId) {
+    return "fdc:" + to_string(fdcId);
+}
+
+void FoodSearchCache::touch(Shard& s, size_t hash) {
+    for (unsigned r = 0; r < SKETCH_ROWS; ++r) {
+        size_t slot = sketchSlot(hash, r);
+        if (counterAt(s.sketch, slot) < 15) s.sketch[slot / 2] += uint8_t(1 << (slot % 2 * 4));
+    }
+    if (++s.samples >= SKETCH_RESET) {
+        // Halve every counter: both nibbles shift right, the high nibble's low bit is masked off
+        for (auto& b : s.sketch) b = uint8_t((b >> 1) & 0x77);
+        s.samples /= 2;
+    }
+}
+
+unsigned FoodSearchCache::frequency(const Shard& s, size_t hash) {
+    unsigned f = 15;
+    for (unsigned r = 0; r < SKETCH_ROWS; ++r) f = min(f, counterAt(s.sketch, sketchSlot(hash, r)));
+    return f;
+}
+
+void FoodSearchCache::erase(Shard& s, list<Entry>::iterator it) {
+    s.bytes -= it->bytes;
+    s.entries.erase(it->key);
+    s.lru.erase(it);
+}
+
+// A fresh entry fills `out` and counts as a hit; an expired one is marked and,
+// once past its stale window, dropped
+bool FoodSearchCache::cached(Shard& s, const string& key, Lookup& out) {
+    auto found = s.entries.find(key);
+    if (found == s.entries.end()) return false;
+    auto it = found->second;
+    const auto now = chrono::steady_clock::now();
+    if (now < it->expires) {
+        s.lru.splice(s.lru.begin(), s.lru, it);
+        ++hits;
+        out.value = it->value;
+        return true;
+    }
+    if (!it->expired) {
+        it->expired = true;
+        ++expirations;
+    }
+    if (now >= it->expires + chrono::seconds(FOOD_CACHE_STALE_S)) erase(s, it);
+    return false;
+}
+
+void FoodSearchCache::insert(Shard& s, size_t hash, const string& key, const Value& value, size_t bytes,
+                             chrono::steady_clock::time_point expires) {
+    if (bytes > shardBytes) return;   // any old entry stays, as a stale fallback
+
+    // A refresh of a cached key always gets in: refusing it would drop the key
+    auto old = s.entries.find(key);
+    if (old != s.entries.end()) {
+        erase(s, old->second);
+    } else if (s.bytes + bytes > shardBytes && !s.lru.empty()) {
+        // TinyLFU: only displace the LRU victim for a key asked for more often
+        const Entry& victim = s.lru.back();
+        if (frequency(s, hash) <= frequency(s, std::hash<string>()(victim.key))) {
+            ++rejections;
+            return;
+        }
+    }
+    while (s.bytes + bytes > shardBytes && !s.lru.empty()) {
+        erase(s, prev(s.lru.end()));
+        ++evictions;
+    }
+    s.lru.push_front({ key, value, bytes, expires });
+    s.entries[key] = s.lru.begin();
+    s.bytes += bytes;
+}
+
+FoodSearchCache::Lookup FoodSearchCache::begin(const string& key) {
+    const size_t hash = std::hash<string>()(key);
+    Shard& s = shardFor(hash);
+
+    Lookup out;
+    FoodDiskCache* diskCache = disk.load();
+    {
+        lock_guard<mutex> lock(s.lock);
+        touch(s, hash);
+        if (cached(s, key, out)) return out;
+        if (s.loading.count(key)) diskCache = nullptr;   // someone is loading it; wait for them
+    }
+
+    // Try disk outside the shard lock; a record within its TTL is a hit
+    Value value;
+    int64_t age;
+    if (diskCache && diskCache->get(key, value, age) && age < ttl.count()) {
+        lock_guard<mutex> lock(s.lock);
+        insert(s, hash, key, value, entryBytes(key, *value),
+               chrono::steady_clock::now() + chrono::seconds(ttl.count() - age));
+        ++hits;
+        ++diskHits;
+        out.value = value;
+        return out;
+    }
+
+    lock_guard<mutex> lock(s.lock);
+    if (diskCache && cached(s, key, out)) return out;   // loaded while we were on disk
+    ++misses;
+    auto flight = s.loading.find(key);
+    if (flight != s.loading.end()) {
+        ++coalesced;
+        out.pending = flight->second.result;
+        return out;
+    }
+    Flight& f = s.loading[key];
+    f.result = f.done.get_future().share();
+    out.leader = true;
+    return out;
+}
+
+FoodSearchCache::Value FoodSearchCache::finish(const string& key, FoodTable result, bool cacheable) {
+    const size_t hash = std::hash<string>()(key);
+    Shard& s = shardFor(hash);
+    const size_t bytes = entryBytes(key, result);
+    Value value = make_shared<const FoodTable>(move(result));
+
+    promise<Value> done;
+    {
+        lock_guard<mutex> lock(s.lock);
+        auto flight = s.loading.find(key);
+        if (flight != s.loading.end()) {
+            done = move(flight->second.done);
+            s.loading.erase(flight);
+        }
+        if (cacheable) insert(s, hash, key, value, bytes, chrono::steady_clock::now() + ttl);
+    }
+    done.set_value(value);   // wake waiters outside the lock
+
+    FoodDiskCache* diskCache = disk.load();
+    if (cacheable && diskCache) diskCache->put(key, *value);
+    return value;
+}
+
+FoodSearchCache::Value FoodSearchCache::getOrLoad(const string& key,
+                                                  const function<bool(FoodTable&)>& load) {
+    Lookup l = begin(key);
+    if (l.value) return l.value;
+    if (!l.leader) return l.pending.get();
+
+    FoodTable result;
+    bool ok = false;
+    try {
+        ok = load(result);
+    } catch (...) {
+        finish(key, {}, false);   // never leave waiters hanging
+        throw;
+    }
+    return finish(key, move(result), ok);
+}
+
+FoodSearchCache::Value FoodSearchCache::stale(const string& key) {
+    Shard& s = shardFor(std::hash<string>()(key));
+    {
+        lock_guard<mutex> lock(s.lock);
+        auto found = s.entries.find(key);
+        if (found != s.entries.end()) {
+            ++staleServed;
+            return found->second->value;
+        }
+    }
+    FoodDiskCache* diskCache = disk.load();
+    Value value;
+    int64_t age;
+    if (!diskCache || !diskCache->get(key, value, age) || age >= ttl.count() + FOOD_CACHE_STALE_S) return nullptr;
+    ++staleServed;
+    return value;
+}
+
+FoodCacheStats FoodSearchCache::stats() const {
+    FoodCacheStats st;
+    st.hits        = hits.load();
+    st.misses      = misses.load();
+    st.coalesced   = coalesced.load();
+    st.evictions   = evictions.load();
+    st.rejections  = rejections.load();
+    st.expirations = expirations.load();
+    st.staleServed = staleServed.load();
+    st.diskHits    = diskHits.load();
+    if (FoodDiskCache* diskCache = disk.load()) st.disk = diskCache->stats();
+    for (size_t i = 0; i < FOOD_CACHE_SHARDS; ++i) {
+        Shard& s = shards[i];
+        lock_guard<mutex> lock(s.lock);
+        st.entries += s.entries.size();
+        st.bytes   += s.bytes;
+    }
+    return st;
+}
+
+void FoodSearchCache::clear() {
+    for (size_t i = 0; i < FOOD_CACHE_SHARDS; ++i) {
+        Shard& s = shards[i];
+        lock_guard<mutex> lock(s.lock);
+        s.lru.clear();
+        s.entries.clear();
+        s.bytes = 0;
+    }
+}
+
+FoodSearchCache& foodSearchCache() {
+    static FoodSearchCache cache;
+    return cache;
+}
@@ -0,0 +1,138 @@
+#ifndef FOOD_CACHE_H
+#define FOOD_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "food_api.h"
+#include "food_disk_cache.h"
+
+const size_t FOOD_CACHE_SHARDS = 16;
+const size_t FOOD_CACHE_BYTES  = 16 << 20;   // across all shards
+const int    FOOD_CACHE_TTL_S  = 3600;       // USDA data changes with quarterly releases
+const int    FOOD_CACHE_STALE_S = 24 * 3600; // how long past its TTL an entry may still serve as a fallback
+
+struct FoodCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t coalesced = 0;   // misses that waited on another thread's load instead of loading
+    uint64_t evictions = 0;   // entries pushed out to make room
+    uint64_t rejections = 0;  // new entries refused by the admission filter
+    uint64_t expirations = 0;
+    uint64_t staleServed = 0; // expired entries handed out because USDA could not answer
+    uint64_t diskHits = 0;    // memory misses answered fresh from the disk cache, counted in hits
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+    FoodDiskCacheStats disk;
+};
+
+// Search results by normalised query and result count, split over shards that
+// each have their own lock, LRU list and byte budget.
+//
+// Admission is TinyLFU: every lookup bumps the key in a per-shard count-min
+// sketch of 4-bit counters, halved periodically so old popularity fades. A new
+// entry that would evict the LRU victim gets in only if its key has been asked
+// for more often than the victim's, so a burst of one-off queries cannot flush
+// the popular ones. A new result for a key already cached always replaces it.
+//
+// Concurrent misses on one key are coalesced: the first caller loads, the
+// rest wait for its result.
+//
+// An expired entry is a miss, but it stays put (still taking its bytes and its
+// LRU place) until a successful load replaces it or FOOD_CACHE_STALE_S passes,
+// so that stale() can hand it out while USDA is down.
+//
+// With a FoodDiskCache attached, a memory miss is looked up on disk before it
+// becomes a load (a record younger than the TTL is a hit and comes back into
+// memory for the rest of its TTL), stale() falls back to disk too, and every
+// cacheable result is also appended there, so a restart starts warm.
+class FoodSearchCache {
+public:
+    typedef std::shared_ptr<const FoodTable> Value;
+
+    // What begin() found. On a hit `value` is set. Otherwise either `pending`
+    // is valid (another thread is loading; wait on it) or `leader` is true and
+    // the caller must load the key and hand the result to finish().
+    struct Lookup {
+        Value value;
+        std::shared_future<Value> pending;
+        bool leader = false;
+    };
+
+    explicit FoodSearchCache(size_t capacityBytes = FOOD_CACHE_BYTES,
+                             std::chrono::seconds ttl = std::chrono::seconds(FOOD_CACHE_TTL_S));
+
+    static std::string key(const std::string& query, int maxResults);
+    // One food by id, as getFoods caches it; never collides with a search key
+    static std::string foodKey(int fdcId);
+
+    Lookup begin(const std::string& key);
+    // Leader only. Publishes the result to waiters; keeps it when `cacheable`.
+    // A result that is not cacheable leaves any stale entry for the key alone.
+    Value finish(const std::string& key, FoodTable result, bool cacheable);
+
+    // begin/finish around load(); results are cached when load() reports success
+    Value getOrLoad(const std::string& key, const std::function<bool(FoodTable&)>& load);
+
+    // The key's entry even if expired, or null; for when a load failed
+    Value stale(const std::string& key);
+
+    FoodCacheStats stats() const;
+    void clear();
+
+    // Not owned; must outlive the cache
+    void attachDisk(FoodDiskCache* diskCache) { disk = diskCache; }
+
+private:
+    struct Entry {
+        std::string key;
+        Value value;
+        size_t bytes;
+        std::chrono::steady_clock::time_point expires;
+        bool expired = false;   // counted in expirations already
+    };
+
+    struct Flight {
+        std::promise<Value> done;
+        std::shared_future<Value> result;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::list<Entry> lru;   // most recent first
+        std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+        std::unordered_map<std::string, Flight> loading;   // keys with a leader fetching them
+        size_t bytes = 0;
+        std::vector<uint8_t> sketch;   // 4 rows of counters, two per byte
+        uint32_t samples = 0;
+    };
+
+    size_t shardBytes;
+    std::chrono::seconds ttl;
+    std::unique_ptr<Shard[]> shards;
+
+    std::atomic<uint64_t> hits{0}, misses{0}, coalesced{0}, evictions{0}, rejections{0}, expirations{0},
+                          staleServed{0}, diskHits{0};
+    std::atomic<FoodDiskCache*> disk{nullptr};
+
+    Shard& shardFor(size_t hash) { return shards[hash % FOOD_CACHE_SHARDS]; }
+    static void touch(Shard& s, size_t hash);
+    static unsigned frequency(const Shard& s, size_t hash);
+    void erase(Shard& s, std::list<Entry>::iterator it);
+    bool cached(Shard& s, const std::string& key, Lookup& out);
+    void insert(Shard& s, size_t hash, const std::string& key, const Value& value, size_t bytes,
+                std::chrono::steady_clock::time_point expires);
+};
+
+// The cache searchFoods and searchFoodsConcurrent consult before going to USDA
+FoodSearchCache& foodSearchCache();
+
+#endif
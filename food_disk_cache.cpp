@@ -0,0 +1,519 @@
+// food_disk_cache.cpp
+#include "food_disk_cache.h"
+#include "food_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static_assert(NUTRIENT_COUNT <= 16, "the record format keeps a 16-bit mask of nutrient slots");
+
+namespace {
+    const char     MAGIC[8] = { 'F', 'D', 'C', 'C', 'A', 'C', 'H', 'E' };
+    const uint32_t VERSION = 2;              // 1 keyed every non-ASCII query alike
+    const size_t   RECORD_HEAD = 8;          // size, crc
+    const size_t   RECORD_FIXED = 8 + 2;     // writtenAt, keyLength
+    const uint32_t MAX_RECORD = 16 << 20;    // anything larger is a torn size field
+    const unsigned BLOOM_HASHES = 7;         // with 10 bits per key: about 1% false positives
+
+    uint32_t crc32(const char* data, size_t n) {
+        static uint32_t table[256];
+        static bool filled = [] {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            return true;
+        }();
+        (void)filled;
+        uint32_t c = 0xFFFFFFFFu;
+        for (size_t i = 0; i < n; ++i) c = table[(c ^ uint8_t(data[i])) & 0xff] ^ (c >> 8);
+        return c ^ 0xFFFFFFFFu;
+    }
+
+    // FNV-1a: stable across builds, unlike std::hash
+    uint64_t keyHash(string_view key) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    int64_t unixNow() {
+        return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void putVarint(string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out += char(uint8_t(v) | 0x80);
+            v >>= 7;
+        }
+        out += char(v);
+    }
+
+    bool getVarint(const char*& p, const char* end, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t b = uint8_t(*p++);
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+    int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+    template <class T> void putRaw(string& out, T v) { out.append(reinterpret_cast<const char*>(&v), sizeof v); }
+    template <class T> T getRaw(const char* p) { T v; memcpy(&v, p, sizeof v); return v; }
+
+    void encodeTable(const FoodTable& t, string& out) {
+        putVarint(out, t.size());
+        int64_t prevId = 0;
+        for (size_t i = 0; i < t.size(); ++i) {
+            putVarint(out, zigzag(int64_t(t.fdcId(i)) - prevId));
+            prevId = t.fdcId(i);
+            string_view d = t.description(i);
+            putVarint(out, d.size());
+            out.append(d.data(), d.size());
+
+            int64_t scaled[NUTRIENT_COUNT];
+            uint16_t mask = 0;
+            for (int n = 0; n < NUTRIENT_COUNT; ++n) {
+                scaled[n] = llround(t.amount(i, Nutrient(n)) * 1000.0);
+                if (scaled[n]) mask |= uint16_t(1u << n);
+            }
+            putRaw(out, mask);
+            for (int n = 0; n < NUTRIENT_COUNT; ++n) {
+                if (scaled[n]) putVarint(out, zigzag(scaled[n]));
+            }
+        }
+    }
+
+    bool decodeTable(const char* p, const char* end, FoodTable& t) {
+        uint64_t rows;
+        if (!getVarint(p, end, rows) || rows > uint64_t(end - p)) return false;
+        t.reserve(size_t(rows));
+        int64_t id = 0;
+        for (uint64_t r = 0; r < rows; ++r) {
+            uint64_t delta, length;
+            if (!getVarint(p, end, delta) || !getVarint(p, end, length) || length > uint64_t(end - p)) return false;
+            id += unzigzag(delta);
+            string_view description(p, size_t(length));
+            p += length;
+            if (end - p < 2) return false;
+            const uint16_t mask = getRaw<uint16_t>(p);
+            p += 2;
+
+            float amount[NUTRIENT_COUNT] = {};
+            for (int n = 0; n < NUTRIENT_COUNT; ++n) {
+                if (!(mask & (1u << n))) continue;
+                uint64_t v;
+                if (!getVarint(p, end, v)) return false;
+                amount[n] = float(double(unzigzag(v)) / 1000.0);
+            }
+            t.add(int(id), description, amount);
+        }
+        return p == end;
+    }
+
+    bool writeHeader(FILE* f) {
+        FoodDiskCacheHeader h = {};
+        memcpy(h.magic, MAGIC, sizeof MAGIC);
+        h.version = VERSION;
+        return fwrite(&h, sizeof h, 1, f) == 1;
+    }
+
+    bool syncFile(FILE* f) {
+        if (fflush(f) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(f)) == 0;
+#else
+        return fsync(fileno(f)) == 0;
+#endif
+    }
+
+    // Makes a rename in the file's directory durable; NTFS journals it already
+    void syncDirectory(const string& path) {
+#ifndef _WIN32
+        size_t slash = path.find_last_of('/');
+        string dir = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        int fd = ::open(dir.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            ::close(fd);
+        }
+#else
+        (void)path;
+#endif
+    }
+
+    // An empty log: just the header
+    bool createLog(const string& path, string& error) {
+        FILE* f = fopen(path.c_str(), "wb");
+        bool ok = f && writeHeader(f) && syncFile(f);
+        if (f && fclose(f) != 0) ok = false;
+        if (!ok) {
+            error = "cannot create " + path;
+            return false;
+        }
+        syncDirectory(path);
+        return true;
+    }
+
+    // The record at `offset`, from the mapping if it is there, else (appended
+    // since the mapping was made) read through `reader`; false unless its
+    // checksum holds
+    bool loadRecord(const MappedFile& view, FILE* reader, uint64_t offset, uint32_t size,
+                    string& buffer, const char*& record) {
+        if (offset + size <= view.size()) {
+            record = view.data() + offset;
+        } else {
+            buffer.resize(size);
+            if (fseek(reader, long(offset), SEEK_SET) != 0 || fread(&buffer[0], 1, size, reader) != size) return false;
+            record = buffer.data();
+        }
+        return crc32(record + RECORD_HEAD, size - RECORD_HEAD) == getRaw<uint32_t>(record + 4);
+    }
+}
+
+void FoodDiskCache::resizeBloom(size_t keys) {
+    size_t words = 64;
+    while (words * 64 < max<size_t>(keys, 1024) * 10) words *= 2;
+    bloom.assign(words, 0);
+    for (const auto& s : slots) addBloom(s.first);
+}
+
+// Double hashing: probe i is h1 + i * h2 over a power-of-two bit array
+void FoodDiskCache::addBloom(uint64_t hash) {
+    const uint64_t bits = bloom.size() * 64 - 1;
+    const uint64_t h2 = (hash >> 32 | hash << 32) | 1;
+    for (unsigned i = 0; i < BLOOM_HASHES; ++i) {
+        uint64_t bit = (hash + i * h2) & bits;
+        bloom[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
+bool FoodDiskCache::mayContain(uint64_t hash) const {
+    const uint64_t bits = bloom.size() * 64 - 1;
+    const uint64_t h2 = (hash >> 32 | hash << 32) | 1;
+    for (unsigned i = 0; i < BLOOM_HASHES; ++i) {
+        uint64_t bit = (hash + i * h2) & bits;
+        if (!(bloom[bit / 64] & (uint64_t(1) << (bit % 64)))) return false;
+    }
+    return true;
+}
+
+bool FoodDiskCache::open(const string& path, string& error) {
+    unique_lock<mutex> guard(lock);
+    return openLocked(guard, path, error);
+}
+
+void FoodDiskCache::close() {
+    lock_guard<mutex> guard(lock);
+    closeLocked();
+}
+
+void FoodDiskCache::closeLocked() {
+    if (appendFile) fclose(appendFile);
+    if (readFile) fclose(readFile);
+    appendFile = readFile = nullptr;
+    mapped.reset();   // a running compaction keeps its own reference
+    slots.clear();
+    bloom.clear();
+    fileSize = liveBytes = 0;
+}
+
+bool FoodDiskCache::openLocked(unique_lock<mutex>& guard, const string& path, string& error) {
+    closeLocked();
+    filePath = path;
+
+    // A missing file, or one that died before its header was written, starts over
+    FILE* probe = fopen(path.c_str(), "rb");
+    long existing = -1;
+    if (probe) {
+        fseek(probe, 0, SEEK_END);
+        existing = ftell(probe);
+        fclose(probe);
+    }
+    if (existing < long(sizeof(FoodDiskCacheHeader)) && !createLog(path, error)) return false;
+
+    auto view = make_shared<MappedFile>();
+    if (!view->open(path, error)) return false;
+    FoodDiskCacheHeader h;
+    memcpy(&h, view->data(), sizeof h);
+    if (memcmp(h.magic, MAGIC, sizeof MAGIC) != 0 || h.version != VERSION) {
+        // Another version, or zeroes after a power loss: it is only a cache
+        cerr << path << " is not a food cache log of this version; starting a new one\n";
+        view->close();
+        if (!createLog(path, error) || !view->open(path, error)) return false;
+    }
+    mapped = view;
+    const char* p = view->data();
+    const size_t n = view->size();
+
+    // Index record headers only; payloads are checked and decoded on demand
+    size_t pos = sizeof h;
+    while (n - pos >= RECORD_HEAD + RECORD_FIXED) {
+        const uint32_t body = getRaw<uint32_t>(p + pos);
+        if (body < RECORD_FIXED || body > MAX_RECORD || body > n - pos - RECORD_HEAD) break;
+        const int64_t writtenAt = getRaw<int64_t>(p + pos + RECORD_HEAD);
+        const uint16_t keyLength = getRaw<uint16_t>(p + pos + RECORD_HEAD + 8);
+        if (keyLength > body - RECORD_FIXED) break;
+        const uint64_t hash = keyHash(string_view(p + pos + RECORD_HEAD + RECORD_FIXED, keyLength));
+
+        Slot slot = { pos, uint32_t(RECORD_HEAD + body), writtenAt };
+        auto found = slots.find(hash);
+        if (found != slots.end()) liveBytes -= found->second.size;
+        slots[hash] = slot;
+        liveBytes += slot.size;
+        pos += slot.size;
+    }
+    fileSize = n;
+    resizeBloom(slots.size() * 2);
+
+    appendFile = fopen(path.c_str(), "ab");
+    readFile = fopen(path.c_str(), "rb");
+    if (!appendFile || !readFile) {
+        closeLocked();
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+
+    // A torn record at the end: appending after it would hide every later record
+    if (pos != n) {
+        cerr << path << ": dropping " << (n - pos) << " bytes of a torn record\n";
+        return rewrite(guard, INT64_MAX, error);
+    }
+    return true;
+}
+
+bool FoodDiskCache::readRecord(const Slot& slot, string& buffer, const char*& record) {
+    if (loadRecord(*mapped, readFile, slot.offset, slot.size, buffer, record)) return true;
+    ++corrupt;
+    return false;
+}
+
+bool FoodDiskCache::get(const string& key, shared_ptr<const FoodTable>& value, int64_t& ageSeconds) {
+    const uint64_t hash = keyHash(key);
+    lock_guard<mutex> guard(lock);
+    if (!appendFile) return false;
+    if (!mayContain(hash)) {
+        ++bloomSkips;
+        return false;
+    }
+    auto found = slots.find(hash);
+    if (found == slots.end()) return false;
+
+    string buffer;
+    const char* record;
+    if (!readRecord(found->second, buffer, record)) {
+        liveBytes -= found->second.size;
+        slots.erase(found);
+        return false;
+    }
+    const uint16_t keyLength = getRaw<uint16_t>(record + RECORD_HEAD + 8);
+    const char* payload = record + RECORD_HEAD + RECORD_FIXED + keyLength;
+    if (string_view(payload - keyLength, keyLength) != key) return false;   // a hash collision
+
+    auto table = make_shared<FoodTable>();
+    if (!decodeTable(payload, record + found->second.size, *table)) {
+        ++corrupt;
+        return false;
+    }
+    ++hits;
+    value = move(table);
+    ageSeconds = max<int64_t>(0, unixNow() - found->second.writtenAt);
+    return true;
+}
+
+void FoodDiskCache::put(const string& key, const FoodTable& value) {
+    if (key.size() > UINT16_MAX) return;
+    string record(RECORD_HEAD, '\0');
+    const int64_t now = unixNow();
+    putRaw(record, now);
+    putRaw(record, uint16_t(key.size()));
+    record += key;
+    encodeTable(value, record);
+    if (record.size() - RECORD_HEAD > MAX_RECORD) return;
+
+    const uint32_t body = uint32_t(record.size() - RECORD_HEAD);
+    const uint32_t crc = crc32(record.data() + RECORD_HEAD, body);
+    memcpy(&record[0], &body, 4);
+    memcpy(&record[4], &crc, 4);
+
+    const uint64_t hash = keyHash(key);
+    lock_guard<mutex> guard(lock);
+    if (!appendFile) return;
+    // One write per record; a crash can only tear the last one
+    if (fwrite(record.data(), 1, record.size(), appendFile) != record.size() || fflush(appendFile) != 0) {
+        cerr << filePath << ": write failed, disk cache closed\n";
+        closeLocked();
+        return;
+    }
+
+    auto found = slots.find(hash);
+    if (found != slots.end()) liveBytes -= found->second.size;
+    slots[hash] = { fileSize, uint32_t(record.size()), now };
+    liveBytes += record.size();
+    fileSize += record.size();
+    ++writes;
+    if (slots.size() * 10 > bloom.size() * 64) resizeBloom(slots.size() * 2);
+    else addBloom(hash);
+}
+
+bool FoodDiskCache::needsCompaction() const {
+    lock_guard<mutex> guard(lock);
+    if (!appendFile) return false;
+    return fileSize > FOOD_DISK_CACHE_BYTES || (fileSize > (1 << 20) && liveBytes < fileSize / 2);
+}
+
+bool FoodDiskCache::compact(int64_t maxAgeSeconds, string& error) {
+    unique_lock<mutex> guard(lock);
+    if (!appendFile) {
+        error = "disk cache is not open";
+        return false;
+    }
+    return rewrite(guard, maxAgeSeconds, error);
+}
+
+bool FoodDiskCache::rewrite(unique_lock<mutex>& guard, int64_t maxAgeSeconds, string& error) {
+    if (compacting) {
+        error = "a compaction is already running";
+        return false;
+    }
+
+    // Newest first until the budget, then written back oldest first
+    const int64_t now = unixNow();
+    vector<Slot> keep;
+    for (const auto& s : slots) {
+        if (now - s.second.writtenAt <= maxAgeSeconds) keep.push_back(s.second);
+    }
+    sort(keep.begin(), keep.end(), [](const Slot& a, const Slot& b) { return a.writtenAt > b.writtenAt; });
+    size_t total = sizeof(FoodDiskCacheHeader), count = 0;
+    while (count < keep.size() && total + keep[count].size <= FOOD_DISK_CACHE_BYTES * 3 / 4) total += keep[count++].size;
+    keep.resize(count);
+    reverse(keep.begin(), keep.end());
+
+    // Copy those without the lock, so lookups and appends carry on: the
+    // mapping never changes, and appended records go through our own reader
+    shared_ptr<MappedFile> view = mapped;
+    const uint64_t copiedTo = fileSize;
+    const string path = filePath;
+    const string tmp = path + ".tmp";
+    compacting = true;
+    guard.unlock();
+
+    FILE* out = fopen(tmp.c_str(), "wb");
+    FILE* reader = fopen(path.c_str(), "rb");
+    bool ok = out && reader && writeHeader(out);
+    uint64_t bad = 0;
+    string buffer;
+    for (const auto& s : keep) {
+        const char* record;
+        if (!ok) break;
+        if (loadRecord(*view, reader, s.offset, s.size, buffer, record)) ok = fwrite(record, 1, s.size, out) == s.size;
+        else ++bad;
+    }
+    if (reader) fclose(reader);
+    view.reset();   // Windows cannot replace a file that is still mapped
+
+    // Then, locked, whatever was appended meanwhile, and the swap
+    guard.lock();
+    compacting = false;
+    corrupt += bad;
+    ok = ok && appendFile;
+    for (const auto& s : slots) {
+        const char* record;
+        if (!ok) break;
+        if (s.second.offset >= copiedTo && readRecord(s.second, buffer, record)) {
+            ok = fwrite(record, 1, s.second.size, out) == s.second.size;
+        }
+    }
+    // Durable before the rename, or a power loss could leave an empty log behind it
+    if (out && !syncFile(out)) ok = false;
+    if (out && fclose(out) != 0) ok = false;
+    if (!ok) {
+        remove(tmp.c_str());
+        error = "cannot write " + tmp;
+        return false;
+    }
+
+    closeLocked();
+#ifdef _WIN32
+    remove(path.c_str());   // rename does not replace on Windows
+#endif
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + tmp + " to " + path;
+        string reopen;
+        openLocked(guard, path, reopen);
+        return false;
+    }
+    syncDirectory(path);
+    ++compactions;
+    return openLocked(guard, path, error);
+}
+
+FoodDiskCacheStats FoodDiskCache::stats() const {
+    lock_guard<mutex> guard(lock);
+    FoodDiskCacheStats st;
+    st.open        = appendFile != nullptr;
+    st.entries     = slots.size();
+    st.fileBytes   = fileSize;
+    st.liveBytes   = liveBytes;
+    st.hits        = hits;
+    st.bloomSkips  = bloomSkips;
+    st.writes      = writes;
+    st.corrupt     = corrupt;
+    st.compactions = compactions;
+    return st;
+}
+
+// --- Process-wide log ---
+
+namespace {
+    FoodDiskCache diskCache;
+    atomic<FoodDiskCache*> diskCachePtr{nullptr};
+}
+
+bool openFoodDiskCache(const string& path, string& error) {
+    if (diskCachePtr.load()) {
+        error = "a disk cache is already open";
+        return false;
+    }
+    if (!diskCache.open(path, error)) return false;
+    diskCachePtr = &diskCache;
+    foodSearchCache().attachDisk(&diskCache);
+
+    // Keep what could still be served, fresh or as a stale fallback
+    thread([] {
+        for (;;) {
+            this_thread::sleep_for(chrono::seconds(FOOD_DISK_CACHE_COMPACT_S));
+            if (!diskCache.needsCompaction()) continue;
+            string compactError;
+            if (!diskCache.compact(FOOD_CACHE_TTL_S + FOOD_CACHE_STALE_S, compactError)) {
+                cerr << "Disk cache compaction failed: " << compactError << "\n";
+            }
+        }
+    }).detach();
+    return true;
+}
+
+FoodDiskCache* foodDiskCache() {
+    return diskCachePtr.load();
+}
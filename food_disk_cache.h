@@ -0,0 +1,115 @@
+#ifndef FOOD_DISK_CACHE_H
+#define FOOD_DISK_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "food_store.h"
+#include "food_table.h"
+
+const size_t FOOD_DISK_CACHE_BYTES     = 64 << 20;  // compaction trims the file back under this
+const int    FOOD_DISK_CACHE_COMPACT_S = 600;       // how often the background thread checks
+
+struct FoodDiskCacheStats {
+    bool     open = false;
+    uint64_t entries = 0;      // keys with a record in the file
+    uint64_t fileBytes = 0;
+    uint64_t liveBytes = 0;    // bytes of those records; the rest is what compaction reclaims
+    uint64_t hits = 0;         // lookups answered from disk
+    uint64_t bloomSkips = 0;   // lookups the Bloom filter ruled out without touching the index
+    uint64_t writes = 0;
+    uint64_t corrupt = 0;      // records that failed their checksum
+    uint64_t compactions = 0;
+};
+
+// On-disk layout, little-endian: header | record*
+//   record:  uint32 size (of everything after crc) | uint32 crc32 (of the same)
+//            | int64 writtenAt (unix seconds) | uint16 keyLength | key | payload
+//   payload: varint rows, then per row: zigzag varint fdcId delta from the
+//            previous row | varint description length | description
+//            | uint16 mask of non-zero nutrient slots | zigzag varint of each
+//            of those amounts x 1000
+// Amounts keep the three decimals FoodTable::amount rounds to, so a table
+// read back is identical to the one written.
+struct FoodDiskCacheHeader {
+    char     magic[8];   // "FDCCACHE"
+    uint32_t version;
+    uint32_t reserved;
+};
+
+// FoodSearchCache results persisted across restarts, as an append-only log:
+// every put() appends a record, a newer record for a key shadows older ones.
+//
+// open() maps the file and walks only the record headers to index key hashes
+// and fill a Bloom filter; payloads are checksummed and decoded when a lookup
+// first asks for them. Records that fail their checksum are skipped; a torn
+// record at the end (a crash mid-append) is cut off by compacting at once. A
+// file without a valid header is replaced by an empty log.
+//
+// compact() copies the newest record of every key still young enough to be
+// useful, newest first until FOOD_DISK_CACHE_BYTES * 3/4, to a temp file
+// without holding the lock, so lookups and appends go on meanwhile. It then
+// locks, adds the records appended since, syncs the temp file and renames it
+// over the log.
+class FoodDiskCache {
+public:
+    FoodDiskCache() = default;
+    ~FoodDiskCache() { close(); }
+    FoodDiskCache(const FoodDiskCache&) = delete;
+    FoodDiskCache& operator=(const FoodDiskCache&) = delete;
+
+    // Opens the log at `path`, creating it if missing
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    // The key's newest record and its age in seconds
+    bool get(const std::string& key, std::shared_ptr<const FoodTable>& value, int64_t& ageSeconds);
+    void put(const std::string& key, const FoodTable& value);
+
+    // Dead records past half the file, or the file over its budget
+    bool needsCompaction() const;
+    // Drops records older than maxAgeSeconds along with shadowed ones
+    bool compact(int64_t maxAgeSeconds, std::string& error);
+
+    FoodDiskCacheStats stats() const;
+
+private:
+    struct Slot {
+        uint64_t offset;      // of the record's size field
+        uint32_t size;        // whole record, size and crc fields included
+        int64_t  writtenAt;
+    };
+
+    mutable std::mutex lock;
+    std::string filePath;
+    std::shared_ptr<MappedFile> mapped;   // the file as it was at open()
+    FILE* appendFile = nullptr;
+    FILE* readFile = nullptr;        // for records appended since
+    uint64_t fileSize = 0;
+    uint64_t liveBytes = 0;
+    std::unordered_map<uint64_t, Slot> slots;   // key hash -> newest record
+    std::vector<uint64_t> bloom;
+    bool compacting = false;
+    uint64_t hits = 0, bloomSkips = 0, writes = 0, corrupt = 0, compactions = 0;
+
+    // These take the lock held; rewrite() lets go of it while copying
+    bool openLocked(std::unique_lock<std::mutex>& guard, const std::string& path, std::string& error);
+    void closeLocked();
+    bool rewrite(std::unique_lock<std::mutex>& guard, int64_t maxAgeSeconds, std::string& error);
+    bool readRecord(const Slot& slot, std::string& buffer, const char*& record);
+    void resizeBloom(size_t keys);
+    void addBloom(uint64_t hash);
+    bool mayContain(uint64_t hash) const;
+};
+
+// Opens the log at `path`, has foodSearchCache() read through to it and write
+// every cacheable result to it, and starts compacting it in the background
+bool openFoodDiskCache(const std::string& path, std::string& error);
+// The process-wide log, or null if none was opened
+FoodDiskCache* foodDiskCache();
+
+#endif
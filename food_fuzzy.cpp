@@ -0,0 +1,206 @@
+// food_fuzzy.cpp
+#include "food_fuzzy.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+    typedef Simd<uint64_t>::vec vword;
+    const size_t LANES = Simd<uint64_t>::LANES;
+
+    int dpDistance(string_view a, string_view b) {
+        vector<int> row(b.size() + 1);
+        for (size_t j = 0; j <= b.size(); ++j) row[j] = int(j);
+        for (size_t i = 1; i <= a.size(); ++i) {
+            int diag = row[0];
+            row[0] = int(i);
+            for (size_t j = 1; j <= b.size(); ++j) {
+                int up = row[j];
+                row[j] = min({ row[j] + 1, row[j - 1] + 1, diag + (a[i - 1] == b[j - 1] ? 0 : 1) });
+                diag = up;
+            }
+        }
+        return row[b.size()];
+    }
+
+    // Bit i of peq[c] is set when pattern[i] == c
+    void patternMasks(string_view pattern, uint64_t peq[256]) {
+        memset(peq, 0, 256 * sizeof(uint64_t));
+        for (size_t i = 0; i < pattern.size(); ++i) peq[static_cast<unsigned char>(pattern[i])] |= uint64_t(1) << i;
+    }
+
+    // One text column of the recurrence (Hyyro's formulation for global distance).
+    // Works unchanged on a scalar word or a vector of independent lanes.
+    template <class W>
+    inline void myersStep(W eq, W& pv, W& mv, W& score, int top) {
+        W xv = eq | mv;
+        W xh = (((eq & pv) + pv) ^ pv) | eq;
+        W ph = mv | ~(xh | pv);
+        W mh = pv & xh;
+        score += (ph >> top) & 1;
+        score -= (mh >> top) & 1;
+        ph = (ph << 1) | 1;   // row 0 of the DP grows by one per text char
+        mh = mh << 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+}
+
+int editDistance(string_view pattern, string_view text) {
+    const size_t m = pattern.size();
+    if (m == 0) return int(text.size());
+    if (m > 64) return dpDistance(pattern, text);
+
+    uint64_t peq[256];
+    patternMasks(pattern, peq);
+    uint64_t pv = ~uint64_t(0), mv = 0, score = m;
+    for (unsigned char c : text) myersStep<uint64_t>(peq[c], pv, mv, score, int(m - 1));
+    return int(score);
+}
+
+void editDistances(string_view pattern, const vector<string_view>& texts, int* out) {
+    const size_t m = pattern.size();
+    if (m == 0 || m > 64) {
+        for (size_t i = 0; i < texts.size(); ++i) out[i] = editDistance(pattern, texts[i]);
+        return;
+    }
+
+    uint64_t peq[256];
+    patternMasks(pattern, peq);
+    const int top = int(m - 1);
+    for (size_t first = 0; first < texts.size(); first += LANES) {
+        const size_t count = min(LANES, texts.size() - first);
+        size_t longest = 0;
+        for (size_t l = 0; l < count; ++l) {
+            longest = max(longest, texts[first + l].size());
+            if (texts[first + l].empty()) out[first + l] = int(m);
+        }
+
+        uint64_t lanes[LANES];
+        for (size_t l = 0; l < LANES; ++l) lanes[l] = ~uint64_t(0);
+        vword pv, mv, score;
+        memcpy(&pv, lanes, sizeof pv);
+        for (size_t l = 0; l < LANES; ++l) lanes[l] = 0;
+        memcpy(&mv, lanes, sizeof mv);
+        for (size_t l = 0; l < LANES; ++l) lanes[l] = m;
+        memcpy(&score, lanes, sizeof score);
+
+        for (size_t j = 0; j < longest; ++j) {
+            // Lanes past the end of their text see no matches; their result was already taken
+            for (size_t l = 0; l < LANES; ++l) {
+                string_view t = l < count ? texts[first + l] : string_view();
+                lanes[l] = j < t.size() ? peq[static_cast<unsigned char>(t[j])] : 0;
+            }
+            vword eq;
+            memcpy(&eq, lanes, sizeof eq);
+            myersStep<vword>(eq, pv, mv, score, top);
+
+            memcpy(lanes, &score, sizeof lanes);
+            for (size_t l = 0; l < count; ++l) {
+                if (texts[first + l].size() == j + 1) out[first + l] = int(lanes[l]);
+            }
+        }
+    }
+}
+
+int maxEditsFor(size_t length) {
+    return length <= 3 ? 0 : (length <= 5 ? 1 : 2);
+}
+
+namespace {
+    // Distinct trigrams of the word padded with \1 and \2 at the ends
+    void trigrams(string_view w, vector<uint32_t>& out) {
+        out.clear();
+        string padded = "\1" + string(w) + "\2";
+        for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+            out.push_back(uint32_t(uint8_t(padded[i])) << 16 | uint32_t(uint8_t(padded[i + 1])) << 8 |
+                          uint8_t(padded[i + 2]));
+        }
+        sort(out.begin(), out.end());
+        out.erase(unique(out.begin(), out.end()), out.end());
+    }
+}
+
+void FuzzyMatcher::build(const vector<string_view>& words, const vector<uint32_t>& weight) {
+    text.clear();
+    start.assign(1, 0);
+    for (auto w : words) {
+        text.append(w.data(), w.size());
+        start.push_back(uint32_t(text.size()));
+    }
+    weights = weight;
+    weights.resize(words.size(), 0);
+
+    vector<pair<uint32_t, uint32_t>> pairs;   // (trigram, word)
+    vector<uint32_t> grams;
+    for (size_t i = 0; i < words.size(); ++i) {
+        trigrams(words[i], grams);
+        for (uint32_t g : grams) pairs.push_back({ g, uint32_t(i) });
+    }
+    sort(pairs.begin(), pairs.end());
+
+    gramKeys.clear();
+    gramStart.clear();
+    gramWords.clear();
+    for (const auto& p : pairs) {
+        if (gramKeys.empty() || gramKeys.back() != p.first) {
+            gramKeys.push_back(p.first);
+            gramStart.push_back(uint32_t(gramWords.size()));
+        }
+        gramWords.push_back(p.second);
+    }
+    gramStart.push_back(uint32_t(gramWords.size()));
+}
+
+long FuzzyMatcher::match(string_view w, int maxEdits) const {
+    if (size() == 0 || maxEdits < 0) return -1;
+
+    thread_local vector<uint16_t> shared;
+    thread_local vector<uint32_t> touched;
+    if (shared.size() < size()) shared.assign(size(), 0);
+    touched.clear();
+
+    vector<uint32_t> grams;
+    trigrams(w, grams);
+    for (uint32_t g : grams) {
+        auto it = lower_bound(gramKeys.begin(), gramKeys.end(), g);
+        if (it == gramKeys.end() || *it != g) continue;
+        size_t k = size_t(it - gramKeys.begin());
+        for (uint32_t i = gramStart[k]; i < gramStart[k + 1]; ++i) {
+            uint32_t id = gramWords[i];
+            if (shared[id]++ == 0) touched.push_back(id);
+        }
+    }
+
+    const long m = long(w.size());
+    const int required = int(max(1L, long(grams.size()) - 3L * maxEdits));
+    vector<uint32_t> ids;
+    vector<string_view> candidates;
+    for (uint32_t id : touched) {
+        long len = long(start[id + 1] - start[id]);
+        if (shared[id] >= required && labs(len - m) <= maxEdits) ids.push_back(id);
+        shared[id] = 0;
+    }
+    // Similar lengths share a vector batch, so fewer lanes idle past their text
+    sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) {
+        return start[a + 1] - start[a] < start[b + 1] - start[b];
+    });
+    for (uint32_t id : ids) candidates.push_back(word(id));
+
+    vector<int> distance(candidates.size());
+    editDistances(w, candidates, distance.data());
+
+    long best = -1;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (distance[i] > maxEdits) continue;
+        if (best < 0) { best = long(i); continue; }
+        const size_t b = size_t(best);
+        if (distance[i] != distance[b] ? distance[i] < distance[b]
+                                       : (weights[ids[i]] != weights[ids[b]] ? weights[ids[i]] > weights[ids[b]]
+                                                                             : ids[i] < ids[b]))
+            best = long(i);
+    }
+    return best < 0 ? -1 : long(ids[size_t(best)]);
+}
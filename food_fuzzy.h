@@ -0,0 +1,47 @@
+#ifndef FOOD_FUZZY_H
+#define FOOD_FUZZY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Levenshtein distance. Myers/Hyyro bit-parallel when the pattern fits one
+// 64-bit word (every food term does), plain DP otherwise.
+int editDistance(std::string_view pattern, std::string_view text);
+
+// editDistance(pattern, texts[i]) for every text, several texts per SIMD
+// vector: each lane runs the bit-parallel recurrence on its own text.
+void editDistances(std::string_view pattern, const std::vector<std::string_view>& texts, int* out);
+
+// Edits tolerated for a word of this length: 0 up to 3 letters, 1 up to 5, else 2
+int maxEditsFor(size_t length);
+
+// Typo-tolerant lookup in a fixed vocabulary. Candidates must share padded
+// trigrams with the word and be within k letters in length; only those are
+// run through editDistances. Trigrams are counted once each, so the q-gram
+// lemma is applied to distinct ones: k edits break at most 3k trigram
+// positions, so of the word's d distinct trigrams at least d - 3k still occur
+// in any word within k edits (and we ask for at least 1).
+class FuzzyMatcher {
+public:
+    // weight breaks distance ties (e.g. how many foods use the word)
+    void build(const std::vector<std::string_view>& words, const std::vector<uint32_t>& weight);
+
+    // Vocabulary index of the closest word within maxEdits, or -1
+    long match(std::string_view word, int maxEdits) const;
+
+    size_t size() const { return weights.size(); }
+
+private:
+    std::string           text;     // vocabulary, concatenated
+    std::vector<uint32_t> start;    // size() + 1 offsets into text
+    std::vector<uint32_t> weights;
+    std::vector<uint32_t> gramKeys;   // sorted distinct trigrams
+    std::vector<uint32_t> gramStart;  // gramKeys.size() + 1 offsets into gramWords
+    std::vector<uint32_t> gramWords;  // words containing each trigram, ascending
+
+    std::string_view word(size_t i) const { return { text.data() + start[i], start[i + 1] - start[i] }; }
+};
+
+#endif
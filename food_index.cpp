@@ -0,0 +1,356 @@
+// food_index.cpp
+#include "food_index.h"
+#include "food_store.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+    const double BM25_K1 = 1.2;
+    const double BM25_B  = 0.75;
+
+    const char     INDEX_MAGIC[8] = { 'F', 'D', 'C', 'I', 'N', 'D', 'E', 'X' };
+    const uint32_t INDEX_VERSION  = 2;   // 2: store checksum instead of its file size
+
+    struct IndexHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t foods;           // store it was built from: count and descriptions
+        uint64_t storeChecksum;
+        uint64_t terms;
+        uint64_t termTextBytes;
+        uint64_t postingBytes;
+    };
+
+    void putVarint(vector<uint8_t>& out, uint32_t v) {
+        while (v >= 0x80) {
+            out.push_back(uint8_t(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(uint8_t(v));
+    }
+
+    uint32_t getVarint(const uint8_t*& p) {
+        uint32_t v = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t b = *p++;
+            v |= uint32_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+    }
+
+    // Bounded: false instead of reading past `end` or a sixth byte
+    bool getVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+        v = 0;
+        for (int shift = 0; p < end && shift < 35; shift += 7) {
+            uint8_t b = *p++;
+            v |= uint32_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // FNV-1a over every description, each closed by a NUL: what the index is
+    // built from, so a rebuilt store of the same size still gets a new index
+    uint64_t storeChecksum(const FoodStore& store) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < store.size(); ++i) {
+            for (unsigned char c : store.description(i)) {
+                h ^= c;
+                h *= 0x100000001b3ull;
+            }
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    template <class T>
+    void writeArray(ofstream& out, const vector<T>& v) {
+        out.write(reinterpret_cast<const char*>(v.data()), streamsize(v.size() * sizeof(T)));
+    }
+
+    template <class T>
+    bool readArray(ifstream& in, vector<T>& v, size_t n) {
+        v.resize(n);
+        in.read(reinterpret_cast<char*>(v.data()), streamsize(n * sizeof(T)));
+        return bool(in);
+    }
+}
+
+vector<string> foodTokens(const string& text) {
+    vector<string> tokens;
+    string token;
+    for (unsigned char c : text) {
+        if (isalnum(c)) {
+            token += char(tolower(c));
+        } else if (!token.empty()) {
+            tokens.push_back(move(token));
+            token.clear();
+        }
+    }
+    if (!token.empty()) tokens.push_back(move(token));
+    return tokens;
+}
+
+void FoodIndex::build(const FoodStore& store) {
+    const size_t n = store.size();
+    unordered_map<string, vector<pair<uint32_t, uint32_t>>> lists;   // term -> (food, tf), foods ascending
+    docLength.assign(n, 0);
+    double totalLength = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        vector<string> tokens = foodTokens(string(store.description(i)));
+        docLength[i] = uint8_t(min<size_t>(tokens.size(), 255));
+        totalLength += docLength[i];
+        for (auto& t : tokens) {
+            auto& list = lists[t];
+            if (!list.empty() && list.back().first == i) ++list.back().second;
+            else list.push_back({ uint32_t(i), 1 });
+        }
+    }
+    avgDocLength = n ? totalLength / n : 0.0;
+
+    vector<const string*> sorted;
+    sorted.reserve(lists.size());
+    for (const auto& entry : lists) sorted.push_back(&entry.first);
+    sort(sorted.begin(), sorted.end(), [](const string* a, const string* b) { return *a < *b; });
+
+    termText.clear();
+    termStart.assign(1, 0);
+    postingStart.assign(1, 0);
+    docFreq.clear();
+    postings.clear();
+    for (const string* term : sorted) {
+        const auto& list = lists[*term];
+        uint32_t prev = 0;
+        for (const auto& p : list) {
+            uint32_t gap = p.first - prev;
+            prev = p.first;
+            putVarint(postings, (gap << 1) | (p.second > 1 ? 1u : 0u));
+            if (p.second > 1) putVarint(postings, p.second);
+        }
+        termText += *term;
+        termStart.push_back(uint32_t(termText.size()));
+        postingStart.push_back(postings.size());
+        docFreq.push_back(uint32_t(list.size()));
+    }
+    buildFuzzy();
+}
+
+void FoodIndex::buildFuzzy() {
+    vector<string_view> words;
+    for (size_t t = 0; t < docFreq.size(); ++t)
+        words.push_back(string_view(termText).substr(termStart[t], termStart[t + 1] - termStart[t]));
+    fuzzy.build(words, docFreq);
+}
+
+bool FoodIndex::save(const string& path, const FoodStore& store, string& error) const {
+    IndexHeader h = {};
+    memcpy(h.magic, INDEX_MAGIC, sizeof h.magic);
+    h.version       = INDEX_VERSION;
+    h.foods         = uint32_t(store.size());
+    h.storeChecksum = storeChecksum(store);
+    h.terms         = docFreq.size();
+    h.termTextBytes = termText.size();
+    h.postingBytes  = postings.size();
+
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        out.write(reinterpret_cast<const char*>(&h), sizeof h);
+        out.write(reinterpret_cast<const char*>(&avgDocLength), sizeof avgDocLength);
+        out.write(termText.data(), streamsize(termText.size()));
+        writeArray(out, termStart);
+        writeArray(out, postingStart);
+        writeArray(out, docFreq);
+        writeArray(out, postings);
+        writeArray(out, docLength);
+        if (!out) {
+            error = "cannot write " + tmp;
+            return false;
+        }
+    }
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + tmp + " to " + path;
+        return false;
+    }
+    return true;
+}
+
+bool FoodIndex::load(const string& path, const FoodStore& store, string& error) {
+    ifstream in(path, ios::binary | ios::ate);
+    const uint64_t fileBytes = in ? uint64_t(in.tellg()) : 0;
+    in.seekg(0);
+    IndexHeader h;
+    if (!in || !in.read(reinterpret_cast<char*>(&h), sizeof h)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    if (memcmp(h.magic, INDEX_MAGIC, sizeof h.magic) != 0 || h.version != INDEX_VERSION) {
+        error = path + " is not a version " + to_string(INDEX_VERSION) + " food index";
+        return false;
+    }
+    if (h.foods != store.size() || h.storeChecksum != storeChecksum(store)) {
+        error = path + " was built from a different store";
+        return false;
+    }
+
+    // The sections must add up to the file before anything is allocated for them
+    if (h.terms > fileBytes || h.termTextBytes > fileBytes || h.postingBytes > fileBytes ||
+        fileBytes != sizeof h + sizeof avgDocLength + h.termTextBytes + (h.terms + 1) * sizeof(uint32_t) +
+                     (h.terms + 1) * sizeof(uint64_t) + h.terms * sizeof(uint32_t) + h.postingBytes + h.foods) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+
+    const size_t terms = size_t(h.terms);
+    termText.resize(size_t(h.termTextBytes));
+    bool ok = bool(in.read(reinterpret_cast<char*>(&avgDocLength), sizeof avgDocLength)) &&
+              bool(in.read(&termText[0], streamsize(termText.size()))) &&
+              readArray(in, termStart, terms + 1) && readArray(in, postingStart, terms + 1) &&
+              readArray(in, docFreq, terms) && readArray(in, postings, size_t(h.postingBytes)) &&
+              readArray(in, docLength, store.size());
+    if (!ok || !valid()) {
+        error = path + " is truncated or corrupt";
+        *this = FoodIndex();
+        return false;
+    }
+    buildFuzzy();
+    return true;
+}
+
+bool FoodIndex::valid() const {
+    const size_t terms = docFreq.size();
+    const size_t foods = docLength.size();
+    if (termStart.size() != terms + 1 || postingStart.size() != terms + 1) return false;
+    if (termStart[0] != 0 || termStart[terms] != termText.size()) return false;
+    if (postingStart[0] != 0 || postingStart[terms] != postings.size()) return false;
+    if (!(avgDocLength >= 0.0) || !isfinite(avgDocLength)) return false;
+
+    string_view prev;
+    for (size_t t = 0; t < terms; ++t) {
+        // Non-empty terms in strictly ascending order, for findTerm's binary search
+        if (termStart[t + 1] <= termStart[t] || termStart[t + 1] > termText.size()) return false;
+        if (postingStart[t + 1] < postingStart[t] || postingStart[t + 1] > postings.size()) return false;
+        string_view term = string_view(termText).substr(termStart[t], termStart[t + 1] - termStart[t]);
+        if (t > 0 && term <= prev) return false;
+        prev = term;
+
+        // Exactly docFreq[t] postings, food indexes ascending and inside the store
+        const uint8_t* p   = postings.data() + postingStart[t];
+        const uint8_t* end = postings.data() + postingStart[t + 1];
+        uint64_t doc = 0;
+        uint32_t count = 0;
+        while (p < end) {
+            uint32_t v, tf;
+            if (!getVarint(p, end, v)) return false;
+            if (count > 0 && (v >> 1) == 0) return false;
+            doc += v >> 1;
+            if (doc >= foods) return false;
+            if ((v & 1) && (!getVarint(p, end, tf) || tf < 2)) return false;
+            ++count;
+        }
+        if (count != docFreq[t]) return false;
+    }
+    return true;
+}
+
+long FoodIndex::findTerm(const string& term) const {
+    size_t lo = 0, hi = docFreq.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = termText.compare(termStart[mid], termStart[mid + 1] - termStart[mid], term);
+        if (cmp == 0) return long(mid);
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return -1;
+}
+
+long FoodIndex::resolveTerm(const string& word) const {
+    long t = findTerm(word);
+    return t >= 0 ? t : fuzzy.match(word, maxEditsFor(word.size()));
+}
+
+string FoodIndex::correct(const string& query) const {
+    string out;
+    for (const auto& word : foodTokens(query)) {
+        long t = resolveTerm(word);
+        if (!out.empty()) out += ' ';
+        if (t >= 0) out.append(termText, termStart[t], termStart[t + 1] - termStart[t]);
+        else out += word;
+    }
+    return out;
+}
+
+vector<FoodIndex::Hit> FoodIndex::search(const string& query, size_t k) const {
+    vector<Hit> hits;
+    const size_t n = docLength.size();
+    if (k == 0 || n == 0) return hits;
+
+    // Per-thread accumulator; only touched entries are reset afterwards
+    thread_local vector<float>    scores;
+    thread_local vector<uint32_t> touched;
+    if (scores.size() < n) scores.assign(n, 0.0f);
+    touched.clear();
+
+    vector<long> terms;
+    for (const auto& word : foodTokens(query)) terms.push_back(resolveTerm(word));
+    sort(terms.begin(), terms.end());
+    terms.erase(unique(terms.begin(), terms.end()), terms.end());
+
+    for (long t : terms) {
+        if (t < 0) continue;
+        const double df  = docFreq[t];
+        const double idf = log(1.0 + (n - df + 0.5) / (df + 0.5));
+        // Almost every posting has tf 1, whose BM25 term depends only on the doc
+        // length: tabulate it once per term so the loop is a lookup and an add
+        float single[256];
+        auto bm25 = [&](double tf, int len) {
+            double norm = BM25_K1 * (1.0 - BM25_B + BM25_B * len / max(avgDocLength, 1e-9));
+            return float(idf * tf * (BM25_K1 + 1.0) / (tf + norm));
+        };
+        for (int len = 0; len < 256; ++len) single[len] = bm25(1.0, len);
+
+        const uint8_t* p   = postings.data() + postingStart[t];
+        const uint8_t* end = postings.data() + postingStart[t + 1];
+        uint32_t doc = 0;
+        while (p < end) {
+            uint32_t v = *p < 0x80 ? *p++ : getVarint(p);
+            doc += v >> 1;
+            float add = (v & 1) ? bm25(getVarint(p), docLength[doc]) : single[docLength[doc]];
+            if (scores[doc] == 0.0f) touched.push_back(doc);
+            scores[doc] += add;
+        }
+    }
+
+    // Top k through a min-heap of size k: most candidates lose one comparison
+    // against the current k-th best and are never copied
+    auto better = [this](const Hit& a, const Hit& b) {
+        if (a.score != b.score) return a.score > b.score;
+        if (docLength[a.food] != docLength[b.food]) return docLength[a.food] < docLength[b.food];
+        return a.food < b.food;
+    };
+    hits.reserve(min(k, touched.size()));
+    for (uint32_t doc : touched) {
+        Hit h = { doc, scores[doc] };
+        scores[doc] = 0.0f;
+        if (hits.size() < k) {
+            hits.push_back(h);
+            push_heap(hits.begin(), hits.end(), better);
+        } else if (better(h, hits.front())) {
+            pop_heap(hits.begin(), hits.end(), better);
+            hits.back() = h;
+            push_heap(hits.begin(), hits.end(), better);
+        }
+    }
+    sort_heap(hits.begin(), hits.end(), better);
+    return hits;
+}
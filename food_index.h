@@ -0,0 +1,62 @@
+#ifndef FOOD_INDEX_H
+#define FOOD_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "food_fuzzy.h"
+
+class FoodStore;
+
+// Lowercased alphanumeric runs: "Chicken, breast (raw)" -> chicken, breast, raw
+std::vector<std::string> foodTokens(const std::string& text);
+
+// Inverted index over FoodStore descriptions with BM25 ranking.
+//
+// Terms are kept sorted in one text blob, so a lookup is a binary search. Each
+// term's posting list is a run of varints in one byte array: the gap to the
+// next food index shifted left once, with the low bit set when a term
+// frequency above 1 follows as another varint. A query decodes the postings
+// of its terms into a per-thread score array and selects the top K.
+class FoodIndex {
+public:
+    struct Hit {
+        uint32_t food;   // FoodStore index
+        float    score;
+    };
+
+    void build(const FoodStore& store);
+
+    // The .idx file records which store it was built from (food count and a
+    // checksum of the descriptions); load fails on a mismatch, and on any
+    // structural damage, leaving the index empty
+    bool save(const std::string& path, const FoodStore& store, std::string& error) const;
+    bool load(const std::string& path, const FoodStore& store, std::string& error);
+
+    // Best k foods for the query, highest score first (ties: shorter description, then index).
+    // Words not in the vocabulary are matched to the closest term within maxEditsFor edits.
+    std::vector<Hit> search(const std::string& query, size_t k) const;
+
+    // The query's words with misspellings replaced by their closest term, space-joined
+    std::string correct(const std::string& query) const;
+
+    size_t terms() const { return docFreq.size(); }
+    size_t postingBytes() const { return postings.size(); }
+
+private:
+    std::string           termText;
+    std::vector<uint32_t> termStart;     // terms() + 1 offsets into termText
+    std::vector<uint64_t> postingStart;  // terms() + 1 offsets into postings
+    std::vector<uint32_t> docFreq;
+    std::vector<uint8_t>  postings;
+    std::vector<uint8_t>  docLength;     // tokens per food, capped at 255
+    double avgDocLength = 0.0;
+    FuzzyMatcher fuzzy;              // over the terms, in term order; rebuilt on load
+
+    bool valid() const;   // everything search() relies on, every posting list decoded
+    long findTerm(const std::string& term) const;
+    long resolveTerm(const std::string& word) const;   // exact, else fuzzy, else -1
+    void buildFuzzy();
+};
+
+#endif
@@ -0,0 +1,338 @@
+// food_store.cpp
+#include "food_store.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// --- MappedFile ---
+
+#ifdef _WIN32
+bool MappedFile::open(const string& path, string& error) {
+    close();
+    // Share writes too: the disk cache appends to a file it has mapped
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || size.QuadPart == 0) {
+        CloseHandle(f);
+        error = path + " is empty";
+        return false;
+    }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (m) CloseHandle(m);
+        CloseHandle(f);
+        error = "cannot map " + path;
+        return false;
+    }
+    file    = f;
+    mapping = m;
+    bytes   = static_cast<const char*>(view);
+    length  = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    bytes = nullptr;
+    length = 0;
+    file = mapping = nullptr;
+}
+#else
+bool MappedFile::open(const string& path, string& error) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error = path + " is empty";
+        return false;
+    }
+    // MAP_SHARED read-only: the pages are the page cache's, shared by every process
+    void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    bytes  = static_cast<const char*>(view);
+    length = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<char*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+}
+#endif
+
+// --- FoodStore ---
+
+namespace {
+    const uint64_t ALIGN = 8;
+
+    uint64_t alignUp(uint64_t n) { return (n + ALIGN - 1) & ~(ALIGN - 1); }
+
+    bool sectionFits(const FoodStoreHeader& h, uint64_t offset, uint64_t bytes) {
+        return offset % ALIGN == 0 && offset <= h.fileSize && bytes <= h.fileSize - offset;
+    }
+
+    string lowercase(string_view s) {
+        string out(s);
+        for (auto& c : out) c = char(tolower(static_cast<unsigned char>(c)));
+        return out;
+    }
+}
+
+bool FoodStore::open(const string& path, string& error) {
+    header = nullptr;
+    wordIndex.reset();
+    if (!file.open(path, error)) return false;
+
+    if (file.size() < sizeof(FoodStoreHeader)) {
+        error = path + " is too small to be a food store";
+        return false;
+    }
+    const auto* h = reinterpret_cast<const FoodStoreHeader*>(file.data());
+    const uint64_t n = h->count;
+    if (memcmp(h->magic, FOOD_STORE_MAGIC, sizeof h->magic) != 0 || h->version != FOOD_STORE_VERSION) {
+        error = path + " is not a version " + to_string(FOOD_STORE_VERSION) + " food store";
+        return false;
+    }
+    if (h->fileSize != file.size() ||
+        !sectionFits(*h, h->idsOffset, n * sizeof(int32_t)) ||
+        !sectionFits(*h, h->textOffsetsOffset, n * sizeof(uint32_t)) ||
+        !sectionFits(*h, h->textLengthsOffset, n * sizeof(uint32_t)) ||
+        !sectionFits(*h, h->nutrientsOffset, n * NUTRIENT_COUNT * sizeof(float)) ||
+        !sectionFits(*h, h->textOffset, h->textSize)) {
+        error = path + " is truncated or corrupt";
+        return false;
+    }
+
+    const char* base = file.data();
+    ids         = reinterpret_cast<const int32_t*>(base + h->idsOffset);
+    textOffsets = reinterpret_cast<const uint32_t*>(base + h->textOffsetsOffset);
+    textLengths = reinterpret_cast<const uint32_t*>(base + h->textLengthsOffset);
+    nutrients   = reinterpret_cast<const float*>(base + h->nutrientsOffset);
+    text        = base + h->textOffset;
+    for (uint64_t i = 0; i < n; ++i) {
+        if (uint64_t(textOffsets[i]) + textLengths[i] > h->textSize) {
+            error = path + " has a description outside its text section";
+            return false;
+        }
+    }
+    header   = h;
+    filePath = path;
+    return true;
+}
+
+FoodItem FoodStore::food(size_t i) const {
+    // FDC publishes at most 3 decimals; undo the float widening noise (66.1f -> 66.0999...)
+    double amount[NUTRIENT_COUNT];
+    for (int n = 0; n < NUTRIENT_COUNT; ++n) amount[n] = round(double(column(Nutrient(n))[i]) * 1000.0) / 1000.0;
+    FoodItem item;
+    item.fdcId       = ids[i];
+    item.description = string(description(i));
+    item.setNutrients(amount);
+    return item;
+}
+
+long FoodStore::find(int id) const {
+    const int32_t* end = ids + size();
+    const int32_t* it = lower_bound(ids, end, id);
+    return (it != end && *it == id) ? long(it - ids) : -1;
+}
+
+vector<size_t> FoodStore::searchRows(const string& query, int maxResults) const {
+    vector<size_t> rows;
+    if (maxResults <= 0) return rows;
+    if (wordIndex) {
+        for (const auto& hit : wordIndex->search(query, size_t(maxResults))) rows.push_back(hit.food);
+        return rows;
+    }
+
+    vector<string> words = foodTokens(query);
+    if (words.empty()) return rows;
+
+    for (size_t i = 0; i < size(); ++i) {
+        string desc = lowercase(description(i));
+        bool all = true;
+        for (const auto& w : words) {
+            if (desc.find(w) == string::npos) { all = false; break; }
+        }
+        if (all) rows.push_back(i);
+    }
+
+    size_t keep = min(rows.size(), size_t(maxResults));
+    partial_sort(rows.begin(), rows.begin() + keep, rows.end(), [this](size_t a, size_t b) {
+        return textLengths[a] != textLengths[b] ? textLengths[a] < textLengths[b] : a < b;
+    });
+    rows.resize(keep);
+    return rows;
+}
+
+vector<FoodItem> FoodStore::search(const string& query, int maxResults) const {
+    vector<FoodItem> results;
+    for (size_t i : searchRows(query, maxResults)) results.push_back(food(i));
+    return results;
+}
+
+FoodTable FoodStore::searchTable(const string& query, int maxResults) const {
+    return table(searchRows(query, maxResults));
+}
+
+FoodTable FoodStore::table(const vector<size_t>& rows) const {
+    FoodTable out;
+    out.reserve(rows.size());
+    for (size_t i : rows) {
+        // The floats are copied as stored
+        float amount[NUTRIENT_COUNT];
+        for (int n = 0; n < NUTRIENT_COUNT; ++n) amount[n] = column(Nutrient(n))[i];
+        out.add(ids[i], description(i), amount);
+    }
+    return out;
+}
+
+void FoodStore::loadOrBuildIndex(const string& indexPath) {
+    auto built = unique_ptr<FoodIndex>(new FoodIndex);
+    string error;
+    if (!built->load(indexPath, *this, error)) {
+        built->build(*this);
+        if (!built->save(indexPath, *this, error)) cerr << "food index not saved: " << error << endl;
+    }
+    wordIndex = move(built);
+}
+
+void FoodStore::buildSuggester() {
+    auto built = unique_ptr<FoodSuggester>(new FoodSuggester);
+    built->build(*this);
+    prefixIndex = move(built);
+}
+
+bool writeFoodStore(const string& path, vector<FoodItem> foods, string& error) {
+    stable_sort(foods.begin(), foods.end(), [](const FoodItem& a, const FoodItem& b) { return a.fdcId < b.fdcId; });
+    foods.erase(unique(foods.begin(), foods.end(),
+                       [](const FoodItem& a, const FoodItem& b) { return a.fdcId == b.fdcId; }),
+                foods.end());
+    const size_t n = foods.size();
+
+    vector<int32_t>  ids(n);
+    vector<uint32_t> offsets(n), lengths(n);
+    vector<float>    nutrients(n * NUTRIENT_COUNT);
+    string text;
+    unordered_map<string, uint32_t> interned;
+    for (size_t i = 0; i < n; ++i) {
+        const FoodItem& f = foods[i];
+        ids[i] = f.fdcId;
+        auto it = interned.find(f.description);
+        if (it == interned.end()) {
+            if (text.size() + f.description.size() > UINT32_MAX) {
+                error = "description text exceeds 4 GiB";
+                return false;
+            }
+            it = interned.emplace(f.description, uint32_t(text.size())).first;
+            text += f.description;
+        }
+        offsets[i] = it->second;
+        lengths[i] = uint32_t(f.description.size());
+        // The named fields are authoritative for the macros
+        for (int c = NUTRIENT_FIBER; c < NUTRIENT_COUNT; ++c) nutrients[c * n + i] = f.nutrients.value[c];
+        nutrients[NUTRIENT_KCAL * n + i]    = float(f.calories);
+        nutrients[NUTRIENT_PROTEIN * n + i] = float(f.protein_g);
+        nutrients[NUTRIENT_CARBS * n + i]   = float(f.carbs_g);
+        nutrients[NUTRIENT_FAT * n + i]     = float(f.fat_g);
+    }
+
+    FoodStoreHeader h = {};
+    memcpy(h.magic, FOOD_STORE_MAGIC, sizeof h.magic);
+    h.version           = FOOD_STORE_VERSION;
+    h.count             = uint32_t(n);
+    h.idsOffset         = alignUp(sizeof h);
+    h.textOffsetsOffset = alignUp(h.idsOffset + n * sizeof(int32_t));
+    h.textLengthsOffset = alignUp(h.textOffsetsOffset + n * sizeof(uint32_t));
+    h.nutrientsOffset   = alignUp(h.textLengthsOffset + n * sizeof(uint32_t));
+    h.textOffset        = alignUp(h.nutrientsOffset + nutrients.size() * sizeof(float));
+    h.textSize          = text.size();
+    h.fileSize          = h.textOffset + h.textSize;
+
+    // Write to a temp name and rename, so a running server never maps a half-written file
+    string tmp = path + ".tmp";
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        auto section = [&out](uint64_t offset, const void* data, size_t bytes) {
+            while (uint64_t(out.tellp()) < offset) out.put('\0');
+            out.write(static_cast<const char*>(data), streamsize(bytes));
+        };
+        section(0, &h, sizeof h);
+        section(h.idsOffset, ids.data(), n * sizeof(int32_t));
+        section(h.textOffsetsOffset, offsets.data(), n * sizeof(uint32_t));
+        section(h.textLengthsOffset, lengths.data(), n * sizeof(uint32_t));
+        section(h.nutrientsOffset, nutrients.data(), nutrients.size() * sizeof(float));
+        section(h.textOffset, text.data(), text.size());
+        if (!out) {
+            error = "cannot write " + tmp;
+            return false;
+        }
+    }
+#ifdef _WIN32
+    remove(path.c_str());   // rename does not replace on Windows
+#endif
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + tmp + " to " + path;
+        return false;
+    }
+    return true;
+}
+
+// --- Process-wide store ---
+
+namespace {
+    FoodStore localStore;
+    atomic<const FoodStore*> localStorePtr{nullptr};
+}
+
+bool openLocalFoodStore(const string& path, string& error) {
+    if (localStorePtr.load()) {
+        error = "a local food store is already open";
+        return false;
+    }
+    if (!localStore.open(path, error)) return false;
+    localStore.loadOrBuildIndex(path + ".idx");
+    localStore.buildSuggester();
+    localStorePtr.store(&localStore);
+    return true;
+}
+
+const FoodStore* localFoodStore() {
+    return localStorePtr.load(memory_order_acquire);
+}
@@ -0,0 +1,114 @@
+#ifndef FOOD_STORE_H
+#define FOOD_STORE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "food_api.h"
+#include "food_index.h"
+#include "food_suggest.h"
+
+// Read-only view of a whole file: mmap on POSIX, a file mapping on Windows.
+// Every process mapping the same file shares its pages through the page cache.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// On-disk layout, all little-endian and 8-byte aligned:
+//   header | int32 fdcId[count] (ascending) | uint32 textOffset[count]
+//   | uint32 textLength[count] | float nutrients[NUTRIENT_COUNT][count] | text
+// Descriptions are interned: foods with the same text share one copy.
+// Nutrient columns are per 100 g, one per nutrients.h slot.
+struct FoodStoreHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t idsOffset;
+    uint64_t textOffsetsOffset;
+    uint64_t textLengthsOffset;
+    uint64_t nutrientsOffset;
+    uint64_t textOffset;
+    uint64_t textSize;
+    uint64_t fileSize;
+};
+
+const char     FOOD_STORE_MAGIC[8]  = { 'F', 'D', 'C', 'S', 'T', 'O', 'R', 'E' };
+const uint32_t FOOD_STORE_VERSION   = 2;   // 2: every NutrientVector slot, not just macros
+
+// Columnar foods served straight out of a mapped file; opening is a map plus
+// a header check, nothing is parsed or copied.
+class FoodStore {
+public:
+    bool open(const std::string& path, std::string& error);
+    bool isOpen() const { return header != nullptr; }
+    const std::string& path() const { return filePath; }
+
+    size_t size() const { return header ? header->count : 0; }
+    int fdcId(size_t i) const { return ids[i]; }
+    std::string_view description(size_t i) const { return { text + textOffsets[i], textLengths[i] }; }
+    const float* column(Nutrient n) const { return nutrients + size_t(n) * size(); }
+    FoodItem food(size_t i) const;
+
+    // Index of fdcId, or -1
+    long find(int fdcId) const;
+
+    // BM25-ranked matches through the attached index; without one, foods whose
+    // description contains every word of the query, shortest description first
+    std::vector<FoodItem> search(const std::string& query, int maxResults) const;
+    FoodTable searchTable(const std::string& query, int maxResults) const;
+    // The given rows, in order, copied column to column
+    FoodTable table(const std::vector<size_t>& rows) const;
+    std::vector<size_t> searchRows(const std::string& query, int maxResults) const;
+
+    // Loads `indexPath` if it matches this store, else builds the index and tries
+    // to save it there so the next start skips the build
+    void loadOrBuildIndex(const std::string& indexPath);
+    const FoodIndex* index() const { return wordIndex.get(); }
+
+    // Prefix autocomplete over the descriptions, built in memory
+    void buildSuggester();
+    const FoodSuggester* suggester() const { return prefixIndex.get(); }
+
+private:
+    MappedFile file;
+    std::string filePath;
+    const FoodStoreHeader* header = nullptr;
+    const int32_t*  ids = nullptr;
+    const uint32_t* textOffsets = nullptr;
+    const uint32_t* textLengths = nullptr;
+    const float*    nutrients = nullptr;
+    const char*     text = nullptr;
+    std::unique_ptr<FoodIndex> wordIndex;
+    std::unique_ptr<FoodSuggester> prefixIndex;
+};
+
+// Sorts by fdcId, drops duplicate ids (first wins), interns descriptions and
+// writes the store. Used by tools/fdc_ingest.
+bool writeFoodStore(const std::string& path, std::vector<FoodItem> foods, std::string& error);
+
+// Process-wide store that searchFoods serves from once opened, indexed from
+// path + ".idx", with a suggester
+bool openLocalFoodStore(const std::string& path, std::string& error);
+const FoodStore* localFoodStore();
+
+#endif
@@ -0,0 +1,176 @@
+// food_suggest.cpp
+#include "food_suggest.h"
+#include "food_store.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+namespace {
+    // Ranges up to this many keys are sorted per request instead of stored
+    const uint32_t SUGGEST_SCAN_LIMIT = 32;
+    const uint32_t NO_KEY = UINT32_MAX;
+
+    string normalise(const string& text, bool keepTrailing) {
+        string out;
+        bool gap = false;
+        for (unsigned char c : text) {
+            if (isalnum(c)) {
+                if (gap && !out.empty()) out += ' ';
+                out += char(tolower(c));
+                gap = false;
+            } else {
+                gap = true;
+            }
+        }
+        if (keepTrailing && gap && !out.empty()) out += ' ';
+        return out;
+    }
+
+    size_t commonPrefix(string_view a, string_view b) {
+        size_t n = min(a.size(), b.size()), i = 0;
+        while (i < n && a[i] == b[i]) ++i;
+        return i;
+    }
+}
+
+string suggestKey(const string& text) {
+    return normalise(text, true);
+}
+
+bool FoodSuggester::better(uint32_t a, uint32_t b) const {
+    if (counts[a] != counts[b]) return counts[a] > counts[b];
+    size_t la = keyStart[a + 1] - keyStart[a], lb = keyStart[b + 1] - keyStart[b];
+    if (la != lb) return la < lb;
+    return a < b;
+}
+
+void FoodSuggester::build(const FoodStore& store) {
+    vector<pair<string, uint32_t>> all;   // (key, food)
+    all.reserve(store.size());
+    for (size_t i = 0; i < store.size(); ++i) {
+        string k = normalise(string(store.description(i)), false);
+        if (!k.empty()) all.push_back({ move(k), uint32_t(i) });
+    }
+    sort(all.begin(), all.end());
+
+    keyText.clear();
+    keyStart.assign(1, 0);
+    counts.clear();
+    foods.clear();
+    for (size_t i = 0; i < all.size(); ++i) {
+        if (i > 0 && all[i].first == all[i - 1].first) {
+            ++counts.back();
+            continue;
+        }
+        keyText += all[i].first;
+        keyStart.push_back(uint32_t(keyText.size()));
+        counts.push_back(1);
+        foods.push_back(all[i].second);
+    }
+    all = vector<pair<string, uint32_t>>();
+
+    // Walk the trie's nodes bottom-up as LCP intervals of the sorted keys:
+    // an open node's list holds the best keys seen inside it so far, and a
+    // closing node hands its list to its parent.
+    struct Open {
+        long lcp;
+        uint32_t lo;
+        vector<uint32_t> top;
+    };
+    auto offer = [this](vector<uint32_t>& top, uint32_t id) {
+        auto at = lower_bound(top.begin(), top.end(), id, [this](uint32_t a, uint32_t b) { return better(a, b); });
+        if (size_t(at - top.begin()) >= SUGGEST_TOP_K) return;
+        top.insert(at, id);
+        if (top.size() > SUGGEST_TOP_K) top.pop_back();
+    };
+
+    vector<pair<pair<uint32_t, uint32_t>, vector<uint32_t>>> stored;   // ((lo, hi), top)
+    auto close = [&](Open& node, uint32_t hi) {
+        if (hi - node.lo > SUGGEST_SCAN_LIMIT) stored.push_back({ { node.lo, hi }, node.top });
+    };
+
+    const uint32_t n = uint32_t(counts.size());
+    vector<Open> stack;
+    stack.push_back({ 0, 0, {} });
+    for (uint32_t i = 1; i <= n; ++i) {
+        long cur = i < n ? long(commonPrefix(key(i - 1), key(i))) : -1;
+        if (cur > stack.back().lcp) {
+            stack.push_back({ cur, i - 1, {} });
+            offer(stack.back().top, i - 1);
+            continue;
+        }
+        offer(stack.back().top, i - 1);
+        while (!stack.empty() && cur < stack.back().lcp) {
+            Open node = move(stack.back());
+            stack.pop_back();
+            close(node, i);
+            if (!stack.empty() && cur <= stack.back().lcp) {
+                for (uint32_t id : node.top) offer(stack.back().top, id);
+            } else if (cur >= 0) {
+                node.lcp = cur;   // becomes the first child of a node starting at the same key
+                stack.push_back(move(node));
+            }
+        }
+    }
+
+    // A chain of single-child nodes can repeat a range; keep one copy
+    sort(stored.begin(), stored.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    nodeLo.clear();
+    nodeHi.clear();
+    nodeTop.clear();
+    for (const auto& s : stored) {
+        if (!nodeLo.empty() && nodeLo.back() == s.first.first && nodeHi.back() == s.first.second) continue;
+        nodeLo.push_back(s.first.first);
+        nodeHi.push_back(s.first.second);
+        for (size_t r = 0; r < SUGGEST_TOP_K; ++r) nodeTop.push_back(r < s.second.size() ? s.second[r] : NO_KEY);
+    }
+}
+
+vector<uint32_t> FoodSuggester::rankRange(uint32_t lo, uint32_t hi, size_t k) const {
+    vector<uint32_t> ids;
+    for (uint32_t i = lo; i < hi; ++i) ids.push_back(i);
+    k = min(k, ids.size());
+    partial_sort(ids.begin(), ids.begin() + k, ids.end(), [this](uint32_t a, uint32_t b) { return better(a, b); });
+    ids.resize(k);
+    return ids;
+}
+
+vector<FoodSuggester::Suggestion> FoodSuggester::suggest(const string& prefix, size_t limit) const {
+    vector<Suggestion> out;
+    string p = suggestKey(prefix);
+    limit = min(limit, SUGGEST_TOP_K);
+    if (p.empty() || limit == 0 || counts.empty()) return out;
+
+    // Keys starting with p: [first key >= p, first key past the p-prefixed run)
+    auto firstWhere = [this](auto pred) {
+        uint32_t lo = 0, hi = uint32_t(counts.size());
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (pred(key(mid))) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo;
+    };
+    uint32_t lo = firstWhere([&p](string_view k) { return k.compare(0, p.size(), p) >= 0; });
+    uint32_t hi = firstWhere([&p](string_view k) { return k.compare(0, p.size(), p) > 0; });
+    if (lo >= hi) return out;
+
+    vector<uint32_t> ids;
+    if (hi - lo <= SUGGEST_SCAN_LIMIT) {
+        ids = rankRange(lo, hi, limit);
+    } else {
+        size_t a = size_t(lower_bound(nodeLo.begin(), nodeLo.end(), lo) - nodeLo.begin());
+        size_t b = size_t(upper_bound(nodeLo.begin(), nodeLo.end(), lo) - nodeLo.begin());
+        auto it = lower_bound(nodeHi.begin() + a, nodeHi.begin() + b, hi);
+        if (it != nodeHi.begin() + b && *it == hi) {
+            const uint32_t* top = nodeTop.data() + size_t(it - nodeHi.begin()) * SUGGEST_TOP_K;
+            for (size_t r = 0; r < limit && top[r] != NO_KEY; ++r) ids.push_back(top[r]);
+        } else {
+            ids = rankRange(lo, hi, limit);   // not reached: every wide prefix range is a node
+        }
+    }
+
+    for (uint32_t id : ids) out.push_back({ foods[id], counts[id] });
+    return out;
+}
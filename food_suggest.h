@@ -0,0 +1,57 @@
+#ifndef FOOD_SUGGEST_H
+#define FOOD_SUGGEST_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class FoodStore;
+
+// Most suggestions a lookup returns
+const size_t SUGGEST_TOP_K = 10;
+
+// Prefix autocomplete over FoodStore descriptions.
+//
+// Descriptions are normalised to their lowercased words joined by single
+// spaces ("Yogurt, Greek, plain" -> "yogurt greek plain") and deduplicated; a
+// key's popularity is how many foods share it. The keys sit sorted in one
+// text blob, so the keys starting with a prefix are one contiguous range found
+// by binary search. Each such range is a node of the implied trie; nodes
+// holding more than a few dozen keys store their top SUGGEST_TOP_K, computed
+// once bottom-up from their children, and smaller ones are ranked on the spot.
+class FoodSuggester {
+public:
+    struct Suggestion {
+        uint32_t food;   // FoodStore index of a food with this description
+        uint32_t count;  // foods sharing the description
+    };
+
+    void build(const FoodStore& store);
+
+    // Most popular descriptions starting with the prefix (ties: shorter, then
+    // alphabetical); at most min(limit, SUGGEST_TOP_K)
+    std::vector<Suggestion> suggest(const std::string& prefix, size_t limit) const;
+
+    size_t keys() const { return counts.size(); }
+    size_t nodes() const { return nodeLo.size(); }
+
+private:
+    std::string           keyText;
+    std::vector<uint32_t> keyStart;    // keys() + 1 offsets into keyText
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> foods;       // representative food per key
+    std::vector<uint32_t> nodeLo;      // precomputed nodes as key ranges [lo, hi),
+    std::vector<uint32_t> nodeHi;      //   sorted by lo then hi
+    std::vector<uint32_t> nodeTop;     // SUGGEST_TOP_K key ids per node, padded with UINT32_MAX
+
+    std::string_view key(size_t i) const { return { keyText.data() + keyStart[i], keyStart[i + 1] - keyStart[i] }; }
+    bool better(uint32_t a, uint32_t b) const;
+    std::vector<uint32_t> rankRange(uint32_t lo, uint32_t hi, size_t k) const;
+};
+
+// The normalised form used for keys and prefixes. A trailing separator in
+// the input is kept as a trailing space, so "rice " no longer matches "ricotta".
+std::string suggestKey(const std::string& text);
+
+#endif
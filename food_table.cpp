@@ -0,0 +1,93 @@
+// food_table.cpp
+#include "food_table.h"
+#include "food_api.h"
+#include <cmath>
+
+using namespace std;
+
+FoodTable::FoodTable(const vector<FoodItem>& items) {
+    reserve(items.size());
+    for (const auto& f : items) add(f);
+}
+
+void FoodTable::reserve(size_t rows) {
+    ids.reserve(rows);
+    textOffset.reserve(rows);
+    textLength.reserve(rows);
+    for (auto& c : columns) c.reserve(rows);
+}
+
+size_t FoodTable::add(int fdcId, string_view description, const float (&amount)[NUTRIENT_COUNT]) {
+    const size_t row = ids.size();
+    const size_t hash = std::hash<string_view>()(description);
+
+    uint32_t offset = uint32_t(text.size());
+    bool found = false;
+    auto range = interned.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (this->description(it->second) == description) {
+            offset = textOffset[it->second];
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        text.append(description.data(), description.size());
+        interned.emplace(hash, uint32_t(row));
+    }
+
+    ids.push_back(fdcId);
+    textOffset.push_back(offset);
+    textLength.push_back(uint32_t(description.size()));
+    for (int n = 0; n < NUTRIENT_COUNT; ++n) columns[n].push_back(amount[n]);
+    return row;
+}
+
+size_t FoodTable::add(const FoodItem& food) {
+    // The named fields are authoritative for the macros
+    float amount[NUTRIENT_COUNT];
+    for (int n = 0; n < NUTRIENT_COUNT; ++n) amount[n] = food.nutrients.value[n];
+    amount[NUTRIENT_KCAL]    = float(food.calories);
+    amount[NUTRIENT_PROTEIN] = float(food.protein_g);
+    amount[NUTRIENT_CARBS]   = float(food.carbs_g);
+    amount[NUTRIENT_FAT]     = float(food.fat_g);
+    return add(food.fdcId, food.description, amount);
+}
+
+size_t FoodTable::add(FoodRef row) {
+    float amount[NUTRIENT_COUNT];
+    for (int n = 0; n < NUTRIENT_COUNT; ++n) amount[n] = float(row.amount(Nutrient(n)));
+    return add(row.fdcId(), row.description(), amount);
+}
+
+double FoodTable::amount(size_t i, Nutrient n) const {
+    return round(double(columns[n][i]) * 1000.0) / 1000.0;
+}
+
+FoodItem FoodTable::item(size_t i) const {
+    double amount[NUTRIENT_COUNT];
+    for (int n = 0; n < NUTRIENT_COUNT; ++n) amount[n] = this->amount(i, Nutrient(n));
+    FoodItem f;
+    f.fdcId = ids[i];
+    f.description = string(description(i));
+    f.setNutrients(amount);
+    return f;
+}
+
+vector<FoodItem> FoodTable::items() const {
+    vector<FoodItem> out;
+    out.reserve(size());
+    for (size_t i = 0; i < size(); ++i) out.push_back(item(i));
+    return out;
+}
+
+size_t FoodTable::bytes() const {
+    size_t b = ids.capacity() * sizeof(int32_t) + (textOffset.capacity() + textLength.capacity()) * sizeof(uint32_t)
+               + text.capacity() + interned.size() * (sizeof(size_t) + sizeof(uint32_t) + 2 * sizeof(void*));
+    for (const auto& c : columns) b += c.capacity() * sizeof(float);
+    return b;
+}
+
+FoodItem FoodRef::item() const {
+    return t->item(i);
+}
@@ -0,0 +1,99 @@
+#ifndef FOOD_TABLE_H
+#define FOOD_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "nutrients.h"
+
+struct FoodItem;
+class FoodTable;
+
+// One row of a FoodTable, by reference
+class FoodRef {
+public:
+    FoodRef(const FoodTable& table, size_t row) : t(&table), i(row) {}
+
+    size_t row() const { return i; }
+    int fdcId() const;
+    std::string_view description() const;
+    double amount(Nutrient n) const;
+    double calories() const  { return amount(NUTRIENT_KCAL); }
+    double protein_g() const { return amount(NUTRIENT_PROTEIN); }
+    double carbs_g() const   { return amount(NUTRIENT_CARBS); }
+    double fat_g() const     { return amount(NUTRIENT_FAT); }
+    FoodItem item() const;
+
+private:
+    const FoodTable* t;
+    size_t i;
+};
+
+// Some rows of a FoodTable, picked by index: a pointer and a count, like a
+// span, so passing it around copies no rows. The table and the index array
+// must outlive the view.
+class FoodRows {
+public:
+    FoodRows() = default;
+    FoodRows(const FoodTable& table, const uint32_t* rows, size_t count) : t(&table), index(rows), n(count) {}
+
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    FoodRef operator[](size_t k) const { return FoodRef(*t, index[k]); }
+
+private:
+    const FoodTable* t = nullptr;
+    const uint32_t* index = nullptr;
+    size_t n = 0;
+};
+
+// Foods stored by column: fdcIds in one array, one float array per nutrients.h
+// slot, and descriptions interned into a single text arena addressed by
+// offset and length. Ranking or solving over many foods streams through the
+// columns it needs instead of visiting a heap-allocated row per food.
+class FoodTable {
+public:
+    FoodTable() = default;
+    explicit FoodTable(const std::vector<FoodItem>& items);
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    void reserve(size_t rows);
+
+    // Appends a row and returns its index; equal descriptions share arena text
+    size_t add(int fdcId, std::string_view description, const float (&amount)[NUTRIENT_COUNT]);
+    size_t add(const FoodItem& food);
+    size_t add(FoodRef row);
+
+    const int32_t* fdcIds() const { return ids.data(); }
+    int fdcId(size_t i) const { return ids[i]; }
+    std::string_view description(size_t i) const { return { text.data() + textOffset[i], textLength[i] }; }
+    const float* column(Nutrient n) const { return columns[n].data(); }
+
+    // Column value widened to double and rounded to FDC's 3 decimals, so
+    // 66.1f reads back as 66.1 rather than 66.0999...
+    double amount(size_t i, Nutrient n) const;
+
+    FoodRef operator[](size_t i) const { return FoodRef(*this, i); }
+    FoodItem item(size_t i) const;
+    std::vector<FoodItem> items() const;
+
+    // Heap bytes held, for cache accounting
+    size_t bytes() const;
+
+private:
+    std::vector<int32_t>  ids;
+    std::vector<uint32_t> textOffset;
+    std::vector<uint32_t> textLength;
+    std::string           text;
+    std::unordered_multimap<size_t, uint32_t> interned;   // description hash -> a row using that text
+    std::vector<float>    columns[NUTRIENT_COUNT];
+};
+
+inline int FoodRef::fdcId() const { return t->fdcId(i); }
+inline std::string_view FoodRef::description() const { return t->description(i); }
+inline double FoodRef::amount(Nutrient n) const { return t->amount(i, n); }
+
+#endif
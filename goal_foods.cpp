@@ -0,0 +1,128 @@
+// goal_foods.cpp
+#include "goal_foods.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+    const char* const GOALS[] = { "cut", "bulk", "maintain" };
+    const size_t GOAL_COUNT = 3;
+
+    size_t goalSlot(const string& goal) {
+        if (goal == "cut") return 0;
+        if (goal == "bulk") return 1;
+        return 2;
+    }
+
+    struct Snapshot {
+        shared_ptr<const GoalFoods> goals[GOAL_COUNT];
+    };
+
+    // Writers publish under the mutex and bump the version; readers keep a
+    // thread-local copy and only touch the mutex when the version moved
+    mutex                       publishLock;
+    shared_ptr<const Snapshot>  published = make_shared<Snapshot>();
+    atomic<uint64_t>            publishedVersion{1};
+
+    shared_ptr<const Snapshot> currentSnapshot() {
+        thread_local uint64_t version = 0;
+        thread_local shared_ptr<const Snapshot> local;
+        uint64_t v = publishedVersion.load(memory_order_acquire);
+        if (v != version) {
+            lock_guard<mutex> lock(publishLock);
+            local = published;
+            version = publishedVersion.load(memory_order_relaxed);
+        }
+        return local;
+    }
+
+    // One request per goal fetches an unpublished pool; the rest wait for it
+    // and take its result, even an empty one, rather than fetch again
+    mutex                       fallbackLocks[GOAL_COUNT];
+    shared_ptr<const GoalFoods> lastFallback[GOAL_COUNT];
+
+    shared_ptr<const GoalFoods> fetchGoal(const string& goal, UsdaPriority priority) {
+        auto pool = make_shared<GoalFoods>();
+        pool->goal = goal;
+        pool->foods = candidateFoods(goal, &pool->firstHits, priority);
+        pool->matrix.assign(pool->foods);
+        pool->fetchedAt = chrono::steady_clock::now();
+        return pool;
+    }
+
+    // An empty pool never replaces anything; a thinner one only an old one
+    bool better(const shared_ptr<const GoalFoods>& fresh, const shared_ptr<const GoalFoods>& old) {
+        if (fresh->foods.empty()) return false;
+        if (!old || fresh->firstHits.size() >= old->firstHits.size()) return true;
+        return fresh->fetchedAt - old->fetchedAt > chrono::seconds(GOAL_FOODS_MAX_AGE_S);
+    }
+
+    // Publishes whichever of `fresh` (null = none for that goal) are better
+    void publish(const shared_ptr<const GoalFoods> (&fresh)[GOAL_COUNT]) {
+        lock_guard<mutex> lock(publishLock);
+        auto next = make_shared<Snapshot>(*published);
+        bool changed = false;
+        for (size_t g = 0; g < GOAL_COUNT; ++g) {
+            if (!fresh[g] || !better(fresh[g], next->goals[g])) continue;
+            next->goals[g] = fresh[g];
+            changed = true;
+        }
+        if (!changed) return;
+        published = next;
+        publishedVersion.fetch_add(1, memory_order_release);
+    }
+}
+
+shared_ptr<const GoalFoods> goalFoods(const string& goal) {
+    size_t slot = goalSlot(goal);
+    shared_ptr<const GoalFoods> pool = currentSnapshot()->goals[slot];
+    if (pool) return pool;
+
+    unique_lock<mutex> lock(fallbackLocks[slot], try_to_lock);
+    if (!lock.owns_lock()) {
+        lock.lock();
+        pool = currentSnapshot()->goals[slot];
+        return pool ? pool : lastFallback[slot];
+    }
+    pool = currentSnapshot()->goals[slot];
+    if (pool) return pool;
+    shared_ptr<const GoalFoods> fresh[GOAL_COUNT];
+    fresh[slot] = fetchGoal(GOALS[slot], USDA_INTERACTIVE);
+    lastFallback[slot] = fresh[slot];
+    publish(fresh);
+    return fresh[slot];
+}
+
+bool refreshGoalFoods() {
+    shared_ptr<const GoalFoods> fresh[GOAL_COUNT];
+    bool complete = true;
+    for (size_t g = 0; g < GOAL_COUNT; ++g) {
+        fresh[g] = fetchGoal(GOALS[g], USDA_BACKGROUND);
+        complete = complete && !fresh[g]->foods.empty();
+    }
+    publish(fresh);
+    return complete;
+}
+
+void startGoalFoodsRefresh(int intervalSeconds) {
+    thread([intervalSeconds] {
+        int retry = GOAL_FOODS_RETRY_MIN_S;
+        for (;;) {
+            if (refreshGoalFoods()) {
+                retry = GOAL_FOODS_RETRY_MIN_S;
+                this_thread::sleep_for(chrono::seconds(intervalSeconds));
+                continue;
+            }
+            // Requests for a goal without a pool fetch it themselves meanwhile
+            int wait = min(retry, intervalSeconds);
+            cerr << "goal foods refresh left a goal without foods; retrying in " << wait << " s" << endl;
+            this_thread::sleep_for(chrono::seconds(wait));
+            retry = min(retry * 2, GOAL_FOODS_RETRY_MAX_S);
+        }
+    }).detach();
+}
@@ -0,0 +1,47 @@
+#ifndef GOAL_FOODS_H
+#define GOAL_FOODS_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "food_api.h"
+#include "meal_solver.h"
+
+// Default time between background refreshes of the goal pools
+const int GOAL_FOODS_REFRESH_S = 6 * 3600;
+// After a refresh that left a goal without foods: first retry, doubling up to the cap
+const int GOAL_FOODS_RETRY_MIN_S = 30;
+const int GOAL_FOODS_RETRY_MAX_S = 15 * 60;
+// A pool older than this is replaced even by one that answered fewer search terms
+const int GOAL_FOODS_MAX_AGE_S = 24 * 3600;
+
+// candidateFoods for one goal, fetched ahead of time and shared read-only by
+// every request
+struct GoalFoods {
+    std::string           goal;        // "cut", "bulk" or "maintain"
+    FoodTable             foods;
+    std::vector<uint32_t> firstHits;   // row of the top result per search term that answered
+    NutrientMatrix        matrix;      // foods, ready for solveMeal
+    std::chrono::steady_clock::time_point fetchedAt;
+};
+
+// The current pool for the goal (unknown goals are "maintain", as in
+// candidateFoods). Reads a thread-local copy of the published snapshot, so
+// after warm-up there is no I/O and no shared lock. Until the first refresh
+// lands the pool is fetched on the spot, by one request at a time per goal,
+// and published for the requests after it.
+std::shared_ptr<const GoalFoods> goalFoods(const std::string& goal);
+
+// Fetches every goal's pool now and again every intervalSeconds on a detached
+// thread; after a pass that left some goal without foods it retries sooner,
+// from GOAL_FOODS_RETRY_MIN_S doubling up to GOAL_FOODS_RETRY_MAX_S. A
+// refresh that answers fewer search terms than the pool it would replace
+// keeps the old pool, unless that is older than GOAL_FOODS_MAX_AGE_S.
+void startGoalFoodsRefresh(int intervalSeconds = GOAL_FOODS_REFRESH_S);
+
+// One refresh pass on the calling thread, queueing for USDA quota behind
+// interactive searches; false if any goal got no foods
+bool refreshGoalFoods();
+
+#endif
@@ -1,4 +1,6 @@
 #include "planner.h"
+#include "plan_kernel.h"
+#include "plan_simd.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
@@ -6,111 +8,98 @@
 
 using namespace std;
 
-namespace {
-    const double KCAL_PER_G_FAT      = 9.0;
-    const double KCAL_PER_G_PROTEIN  = 4.0;
-    const double KCAL_PER_G_CARB     = 4.0;
-    const double KCAL_PER_KG_FAT     = 7700.0;  // Approximation for body fat loss/gain
-    const double MIN_CALORIE_MULTIPLIER = 1.1;   // Minimum calories as % of BMR
-    const double EPSILON             = 1e-9;     // For floating-point comparisons
-}
+const PlanFieldError PLAN_FIELD_ERRORS[PLAN_FIELD_COUNT] = {
+    { PLAN_BAD_WEIGHT,   "weight",     "Weight must be between 0 and 500 kg" },
+    { PLAN_BAD_HEIGHT,   "height",     "Height must be between 0 and 300 cm" },
+    { PLAN_BAD_AGE,      "ageYears",   "Age must be between 15 and 120 years" },
+    { PLAN_BAD_BODY_FAT, "bodyFatPct", "Body fat must be between 0 and 75 percent" },
+};
 
-void validateInput(const UserInput& u) {
-    if (u.weight <= 0 || u.weight > 500)
-        throw invalid_argument("Weight must be between 0 and 500 kg");
-    if (u.height <= 0 || u.height > 300)
-        throw invalid_argument("Height must be between 0 and 300 cm");
-    if (u.ageYears < 15 || u.ageYears > 120)
-        throw invalid_argument("Age must be between 15 and 120 years");
+unsigned char checkInput(const UserInput& u) noexcept {
+    return planRangeStatus(u.weight, u.height, u.ageYears);
 }
 
-double activityFactor(Activity a) {
-    switch (a) {
-        case Activity::Sedentary: return 1.20;
-        case Activity::Light:     return 1.375;
-        case Activity::Moderate:  return 1.55;
-        case Activity::Very:      return 1.725;
-        case Activity::Extra:     return 1.90;
-        default:                  return 1.55;
+const char* planStatusMessage(unsigned char status) noexcept {
+    for (const auto& e : PLAN_FIELD_ERRORS) {
+        if (status & e.field) return e.message;
     }
+    return "";
 }
 
-double bmrMifflinStJeor(Sex sex, double kg, double cm, int age) {
-    double base = 10.0 * kg + 6.25 * cm - 5.0 * age;
-    return (sex == Sex::Male) ? base + 5.0 : base - 161.0;
+void validateInput(const UserInput& u) {
+    unsigned char status = checkInput(u);
+    if (status != PLAN_OK)
+        throw invalid_argument(planStatusMessage(status));
 }
 
-double paceFraction(Pace p) {
-    switch (p) {
-        case Pace::Slow:       return 0.0025;  // 0.25%
-        case Pace::Normal:     return 0.0050;  // 0.5%
-        case Pace::Aggressive: return 0.0100;  // 1.0%
-        default:               return 0.0050;
-    }
+template <class Bmr>
+PlanOutcome tryComputePlanWith(const UserInput& u) noexcept {
+    PlanOutcome out;
+    out.status = checkInput(u);
+    if constexpr (Bmr::USES_LEAN_MASS) out.status |= bodyFatStatus(u.bodyFatPct);
+    if (!out.ok()) return out;
+
+    // All enum-dependent factors come from the compile-time table; see plan_kernel.h
+    const PlanCoefficients& c = planCoefficients<Bmr>(u.sex, u.activity, u.goal, u.pace);
+    const double age  = u.ageYears;
+    const double lean = leanMassKg(u.weight, u.bodyFatPct);
+
+    PlanTerms<double> t;
+    evalPlan<Bmr>(c, u.weight, u.height, age, lean, t);
+    out.result = planResultFrom(t, paceUsed(u.goal, u.pace));
+    return out;
 }
 
-MacroPlan computeMacros(Goal goal, double weightKg, double calories) {
-    const double fatPercentage = 0.25;
-
-    double proteinPerKg;
-    switch (goal) {
-        case Goal::Cut:      proteinPerKg = 2.2; break;
-        case Goal::Maintain: proteinPerKg = 1.8; break;
-        case Goal::Bulk:     proteinPerKg = 1.6; break;
-        default:             proteinPerKg = 1.8;
-    }
-
-    double protein_g   = proteinPerKg * weightKg;
-    double fat_kcal    = calories * fatPercentage;
-    double fat_g       = fat_kcal / KCAL_PER_G_FAT;
-    double protein_kcal = protein_g * KCAL_PER_G_PROTEIN;
+template PlanOutcome tryComputePlanWith<MifflinStJeor>(const UserInput&) noexcept;
+template PlanOutcome tryComputePlanWith<HarrisBenedict>(const UserInput&) noexcept;
+template PlanOutcome tryComputePlanWith<KatchMcArdle>(const UserInput&) noexcept;
+template PlanOutcome tryComputePlanWith<Cunningham>(const UserInput&) noexcept;
 
-    double remaining_kcal = max(0.0, calories - protein_kcal - fat_kcal);
-    double carbs_g       = remaining_kcal / KCAL_PER_G_CARB;
+PlanOutcome tryComputePlan(const UserInput& u) noexcept {
+    return tryComputePlanWith<MifflinStJeor>(u);
+}
 
-    return { calories, protein_g, fat_g, carbs_g };
+PlanOutcome tryComputePlan(const UserInput& u, BmrFormula formula) noexcept {
+    switch (formula) {
+        case BmrFormula::HarrisBenedict: return tryComputePlanWith<HarrisBenedict>(u);
+        case BmrFormula::KatchMcArdle:   return tryComputePlanWith<KatchMcArdle>(u);
+        case BmrFormula::Cunningham:     return tryComputePlanWith<Cunningham>(u);
+        default:                         return tryComputePlanWith<MifflinStJeor>(u);
+    }
 }
 
 PlanResult computePlan(const UserInput& u) {
-    validateInput(u);
-
-    PlanResult res;
-
-    // Calculate base metabolic rates
-    res.bmr  = bmrMifflinStJeor(u.sex, u.weight, u.height, u.ageYears);
-    res.tdee = res.bmr * activityFactor(u.activity);
-
-    double targetCalories;
-
-    if (u.goal == Goal::Maintain) {
-        // Handle maintenance goal
-        res.paceUsed      = Pace::Normal;
-        res.weeklyChangeKg = 0.0;
-        res.weeklyChangeLb = 0.0;
-        targetCalories    = res.tdee;
-    } else {
-        // Calculate weight change targets (Cut or Bulk)
-        res.paceUsed       = u.pace;
-        double weeklyChangeKg = paceFraction(u.pace) * u.weight;
-        res.weeklyChangeKg = weeklyChangeKg;
-        res.weeklyChangeLb = weeklyChangeKg * 2.20462;
-
-        double weeklyKcal     = weeklyChangeKg * KCAL_PER_KG_FAT;
-        double dailyKcalAdjust = weeklyKcal / 7.0;
-
-        // Calculate calorie targets
-        targetCalories = (u.goal == Goal::Cut)
-            ? res.tdee - dailyKcalAdjust
-            : res.tdee + dailyKcalAdjust;
-
-        // Safety floor when cutting: don't go below MIN_CALORIE_MULTIPLIER * BMR
-        if (u.goal == Goal::Cut) {
-            targetCalories = max(targetCalories, res.bmr * MIN_CALORIE_MULTIPLIER);
-        }
-    }
+    PlanOutcome out = tryComputePlan(u);
+    if (!out.ok())
+        throw invalid_argument(planStatusMessage(out.status));
+    return out.result;
+}
 
-    res.targetCalories = targetCalories;
-    res.macros         = computeMacros(u.goal, u.weight, targetCalories);
+// --- Batch planning ---
+
+void PlanBatchInput::push_back(const UserInput& u) {
+    sex.push_back(u.sex);
+    ageYears.push_back(u.ageYears);
+    height.push_back(u.height);
+    weight.push_back(u.weight);
+    activity.push_back(u.activity);
+    goal.push_back(u.goal);
+    pace.push_back(u.pace);
+    bodyFatPct.push_back(u.bodyFatPct);
+}
+
+void PlanBatchInput::clear() {
+    sex.clear();
+    ageYears.clear();
+    height.clear();
+    weight.clear();
+    activity.clear();
+    goal.clear();
+    pace.clear();
+    bodyFatPct.clear();
+}
 
-    return res;
+void computePlanBatch(const PlanBatchInput& in, PlanBatchResult& out) {
+    // Same evalPlan as computePlan, a SIMD register's worth of users per call
+    planBatch(in, out, PLAN_TABLE.data());
 }
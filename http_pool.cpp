@@ -0,0 +1,265 @@
+// http_pool.cpp
+#include "http_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    size_t discardBody(void*, size_t size, size_t nmemb, void*) { return size * nmemb; }
+
+    size_t appendBody(void* contents, size_t size, size_t nmemb, void* out) {
+        static_cast<string*>(out)->append(static_cast<char*>(contents), size * nmemb);
+        return size * nmemb;
+    }
+
+    // Picks X-RateLimit-Remaining out of the response headers
+    size_t readHeader(char* line, size_t size, size_t nmemb, void* out) {
+        static const char NAME[] = "x-ratelimit-remaining:";
+        const size_t n = size * nmemb, nameLength = sizeof(NAME) - 1;
+        if (n > nameLength) {
+            bool match = true;
+            for (size_t i = 0; i < nameLength && match; ++i) match = tolower((unsigned char)line[i]) == NAME[i];
+            if (match) *static_cast<long*>(out) = strtol(string(line + nameLength, n - nameLength).c_str(), nullptr, 10);
+        }
+        return n;
+    }
+
+    // Options every pooled request starts from; callers add URL and write callback
+    void applyDefaults(CURL* curl, CURLSH* share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);        // safe to use from worker threads
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);  // For Windows SSL issues
+    }
+
+    class HandlePool {
+    public:
+        static HandlePool& instance() {
+            static HandlePool pool;
+            return pool;
+        }
+
+        CURL* acquire() {
+            {
+                lock_guard<mutex> lock(idleMutex);
+                if (!idle.empty()) {
+                    CURL* curl = idle.back();
+                    idle.pop_back();
+                    return curl;
+                }
+            }
+            CURL* curl = curl_easy_init();
+            if (curl) applyDefaults(curl, share);
+            return curl;
+        }
+
+        // curl_easy_reset drops per-request options but keeps the handle's
+        // caches; the shared ones live in the CURLSH anyway
+        void release(CURL* curl) {
+            curl_easy_reset(curl);
+            applyDefaults(curl, share);
+            lock_guard<mutex> lock(idleMutex);
+            idle.push_back(curl);
+        }
+
+    private:
+        CURLSH* share = nullptr;
+        mutex idleMutex;
+        vector<CURL*> idle;
+        mutex dataLocks[CURL_LOCK_DATA_LAST];   // one per kind of shared data
+
+        HandlePool() {
+            curl_global_init(CURL_GLOBAL_DEFAULT);
+            share = curl_share_init();
+            curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockData);
+            curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockData);
+            curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        }
+
+        // Lives until exit; handles may still be borrowed by detached threads
+        ~HandlePool() = default;
+
+        static void lockData(CURL*, curl_lock_data data, curl_lock_access, void* self) {
+            static_cast<HandlePool*>(self)->dataLocks[data].lock();
+        }
+        static void unlockData(CURL*, curl_lock_data data, void* self) {
+            static_cast<HandlePool*>(self)->dataLocks[data].unlock();
+        }
+    };
+}
+
+PooledCurl::PooledCurl() : handle(HandlePool::instance().acquire()) {}
+
+PooledCurl::~PooledCurl() {
+    if (handle) HandlePool::instance().release(handle);
+}
+
+string urlEncode(const string& s) {
+    static const char HEX[] = "0123456789ABCDEF";
+    string out;
+    out.reserve(s.size() * 3);
+    for (unsigned char c : s) {
+        bool unreserved = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                          c == '-' || c == '.' || c == '_' || c == '~';
+        if (unreserved) {
+            out += char(c);
+        } else {
+            out += '%';
+            out += HEX[c >> 4];
+            out += HEX[c & 15];
+        }
+    }
+    return out;
+}
+
+void prewarmHttpPool(const string& url, int connections) {
+    // Each connection needs its own in-flight request, so warm them concurrently
+    vector<thread> workers;
+    for (int i = 0; i < connections; ++i) {
+        workers.emplace_back([&url] {
+            PooledCurl curl;
+            if (!curl) return;
+            curl_easy_setopt(curl.get(), CURLOPT_URL, url.c_str());
+            curl_easy_setopt(curl.get(), CURLOPT_NOBODY, 1L);
+            curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, discardBody);
+            CURLcode res = curl_easy_perform(curl.get());
+            if (res != CURLE_OK) cerr << "cURL prewarm error: " << curl_easy_strerror(res) << endl;
+        });
+    }
+    for (auto& t : workers) t.join();
+}
+
+vector<HttpResponse> httpGetAll(const vector<string>& urls, int perRequestMs, int totalMs,
+                                int connectMs, int hedgeAfterMs, const function<bool(size_t)>& mayHedge) {
+    typedef chrono::steady_clock Clock;
+    const int MAX_POLL_MS = 100;
+
+    // One request on the wire; a url has one, or two once hedged
+    struct Transfer {
+        Transfer(size_t url, bool hedge) : url(url), hedge(hedge) {}
+        size_t url;
+        bool hedge;
+        bool attached = false;
+        PooledCurl curl;
+        string body;
+        long rateLimitRemaining = -1;
+    };
+
+    vector<HttpResponse> out(urls.size());
+    vector<unique_ptr<Transfer>> transfers;
+    vector<int> inFlight(urls.size(), 0);
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        for (auto& r : out) r.error = "curl_multi_init failed";
+        return out;
+    }
+
+    auto start = [&](size_t i, bool hedge) {
+        transfers.emplace_back(new Transfer(i, hedge));
+        Transfer* t = transfers.back().get();
+        CURL* curl = t->curl.get();
+        if (!curl) {
+            if (!hedge) out[i].error = "curl_easy_init failed";
+            return;
+        }
+        curl_easy_setopt(curl, CURLOPT_URL, urls[i].c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, appendBody);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &t->body);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, readHeader);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &t->rateLimitRemaining);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, t);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, long(perRequestMs));
+        if (connectMs > 0) curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, long(connectMs));
+        curl_multi_add_handle(multi, curl);
+        t->attached = true;
+        ++inFlight[i];
+    };
+
+    auto detach = [&](Transfer* t) {
+        if (!t->attached) return;
+        curl_multi_remove_handle(multi, t->curl.get());
+        t->attached = false;
+        --inFlight[t->url];
+    };
+
+    const Clock::time_point begun = Clock::now();
+    auto sinceStart = [&] { return long(chrono::duration_cast<chrono::milliseconds>(Clock::now() - begun).count()); };
+
+    // A failure is only final once no other attempt at the url is still running
+    auto finished = [&](CURL* curl, CURLcode result) {
+        Transfer* t = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, reinterpret_cast<char**>(&t));
+        if (!t) return;
+        detach(t);
+        HttpResponse& r = out[t->url];
+        if (r.ok) return;
+        if (result == CURLE_OK) {
+            r.ok = true;
+            r.error.clear();
+            r.body = move(t->body);
+            r.elapsedMs = sinceStart();
+            r.hedgeWon = t->hedge;
+            r.rateLimitRemaining = t->rateLimitRemaining;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &r.status);
+            for (auto& other : transfers) {
+                if (other->url == t->url) detach(other.get());
+            }
+        } else if (inFlight[t->url] == 0) {
+            r.error = curl_easy_strerror(result);
+            r.elapsedMs = sinceStart();
+        }
+    };
+
+    for (size_t i = 0; i < urls.size(); ++i) start(i, false);
+
+    const Clock::time_point deadline = begun + chrono::milliseconds(totalMs);
+    bool hedging = hedgeAfterMs > 0;
+    int running = 0;
+    do {
+        curl_multi_perform(multi, &running);
+        int queued;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+            if (msg->msg == CURLMSG_DONE) finished(msg->easy_handle, msg->data.result);
+        }
+
+        long now = sinceStart();
+        if (hedging && now >= hedgeAfterMs) {
+            hedging = false;
+            for (size_t i = 0; i < urls.size(); ++i) {
+                if (out[i].ok || inFlight[i] != 1) continue;
+                if (mayHedge && !mayHedge(i)) continue;
+                out[i].hedged = true;
+                start(i, true);
+            }
+            continue;   // get the duplicates going before sleeping
+        }
+        if (running == 0) break;
+
+        long left = totalMs - now;
+        if (left <= 0) break;
+        long wait = min<long>(left, MAX_POLL_MS);
+        if (hedging) wait = min<long>(wait, max(0L, hedgeAfterMs - now));
+        curl_multi_poll(multi, nullptr, 0, int(wait), nullptr);
+    } while (Clock::now() < deadline);
+
+    // Anything still attached missed the overall deadline
+    for (auto& t : transfers) detach(t.get());
+    for (auto& r : out) {
+        if (r.ok || !r.error.empty()) continue;
+        r.error = "deadline exceeded";
+        r.elapsedMs = sinceStart();
+    }
+    curl_multi_cleanup(multi);
+    return out;
+}
@@ -0,0 +1,56 @@
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+
+// An easy handle borrowed from a process-wide pool. All pooled handles share one
+// CURLSH (DNS cache, TLS session cache and connection cache), so a request on
+// any handle can reuse a keep-alive connection opened by another. The handle is
+// reset and returned to the pool on destruction.
+class PooledCurl {
+public:
+    PooledCurl();
+    ~PooledCurl();
+    PooledCurl(const PooledCurl&) = delete;
+    PooledCurl& operator=(const PooledCurl&) = delete;
+
+    CURL* get() const { return handle; }
+    explicit operator bool() const { return handle != nullptr; }
+
+private:
+    CURL* handle;
+};
+
+struct HttpResponse {
+    bool        ok = false;    // transfer finished before its deadline
+    long        status = 0;    // HTTP status code, 0 if none was received
+    std::string body;
+    std::string error;         // curl error text when !ok
+    long        elapsedMs = 0; // from the first attempt's start to the answer
+    bool        hedged = false;    // a duplicate request was sent
+    bool        hedgeWon = false;  // ... and answered first
+    long        rateLimitRemaining = -1;   // X-RateLimit-Remaining header, -1 if absent
+};
+
+// GETs every url concurrently on pooled handles driven by one curl_multi. Each
+// transfer is capped at perRequestMs and its connect phase at connectMs (0 =
+// curl's default); whatever is still running at totalMs is abandoned and
+// reported as timed out. With hedgeAfterMs > 0, a url still unanswered after
+// that long gets one duplicate request and the first success wins; the loser
+// is cancelled. mayHedge, if given, is asked with the url's index just before
+// its duplicate would go out and can refuse it. Results line up with urls.
+std::vector<HttpResponse> httpGetAll(const std::vector<std::string>& urls, int perRequestMs, int totalMs,
+                                     int connectMs = 0, int hedgeAfterMs = 0,
+                                     const std::function<bool(size_t)>& mayHedge = nullptr);
+
+// Percent-encodes everything but RFC 3986 unreserved characters
+std::string urlEncode(const std::string& s);
+
+// Opens up to `connections` keep-alive connections to url's host in parallel
+// (HEAD requests), leaving them in the shared connection cache. Blocks until done.
+void prewarmHttpPool(const std::string& url, int connections);
+
+#endif
@@ -0,0 +1,238 @@
+// meal_plan.cpp
+#include "meal_plan.h"
+#include "plan_workers.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+using namespace std;
+
+namespace {
+    typedef chrono::steady_clock Clock;
+
+    const int    CLOCK_CHECK_EVERY = 32;   // moves between deadline checks
+    const double START_TEMPERATURE = 0.05; // in macroMiss units, cooled linearly to 0
+    const int    PICK_ATTEMPTS     = 8;
+    const double EXCHANGE_SHARE    = 0.25; // moves that trade foods between meals
+
+    struct Problem {
+        const NutrientMatrix&    matrix;
+        const WeeklyPlanOptions& opt;
+        vector<MacroPlan> slotTargets;
+        size_t slots = 0, meals = 0;
+        Clock::time_point start, deadline;
+
+        Problem(const NutrientMatrix& m, const WeeklyPlanOptions& o) : matrix(m), opt(o) {}
+        const MacroPlan& target(size_t meal) const { return slotTargets[meal % slots]; }
+    };
+
+    struct State {
+        vector<vector<size_t>> chosen;   // foods per meal
+        vector<MealSolution>   solved;
+        vector<double>         miss;
+        double score = 0.0;
+    };
+
+    struct Worker {
+        const Problem& p;
+        mt19937 rng;
+        uniform_real_distribution<double> unit{0.0, 1.0};
+        vector<int> uses;   // meals each food is in
+        State  current, best;
+        size_t evaluated = 0;
+
+        Worker(const Problem& problem, unsigned seed) : p(problem), rng(seed), uses(problem.matrix.foods, 0) {}
+
+        size_t randomIndex(size_t n) { return uniform_int_distribution<size_t>(0, n - 1)(rng); }
+
+        // A food not already in this meal and still under the repeat limit, or npos
+        size_t pickFood(const vector<size_t>& meal) {
+            for (int attempt = 0; attempt < PICK_ATTEMPTS; ++attempt) {
+                size_t f = randomIndex(p.matrix.foods);
+                if (uses[f] < p.opt.maxRepeats && find(meal.begin(), meal.end(), f) == meal.end()) return f;
+            }
+            return string::npos;
+        }
+
+        void evaluate(size_t m, const vector<size_t>& foods, MealSolution& solution, double& miss) {
+            solution = solveMeal(p.matrix, foods, p.target(m), p.opt.solver);
+            miss = macroMiss(solution.totals, p.target(m));
+            ++evaluated;
+        }
+
+        void init() {
+            current.chosen.assign(p.meals, {});
+            current.solved.assign(p.meals, {});
+            current.miss.assign(p.meals, 0.0);
+            // Round-robin so a short pool is spread over the week, not spent on day 1
+            for (int k = 0; k < p.opt.foodsPerMeal; ++k) {
+                for (size_t m = 0; m < p.meals; ++m) {
+                    size_t f = pickFood(current.chosen[m]);
+                    if (f == string::npos) continue;
+                    current.chosen[m].push_back(f);
+                    ++uses[f];
+                }
+            }
+            for (size_t m = 0; m < p.meals; ++m) {
+                evaluate(m, current.chosen[m], current.solved[m], current.miss[m]);
+                current.score += current.miss[m];
+            }
+            best = current;
+        }
+
+        void run() {
+            init();
+            const double budget = chrono::duration<double>(p.deadline - p.start).count();
+            double temperature = START_TEMPERATURE;
+            vector<size_t> candidate;
+            MealSolution solution;
+
+            for (long iter = 0;; ++iter) {
+                if (iter % CLOCK_CHECK_EVERY == 0) {
+                    Clock::time_point now = Clock::now();
+                    if (now >= p.deadline) break;
+                    double elapsed = chrono::duration<double>(now - p.start).count();
+                    temperature = START_TEMPERATURE * max(0.0, 1.0 - elapsed / budget);
+                }
+
+                // Move: swap one food of a random meal for an unused one (or add one if the
+                // meal has room); when the pool is spent, or one time in four, trade foods
+                // between two meals instead, which keeps every repeat count unchanged
+                size_t m = randomIndex(p.meals);
+                candidate = current.chosen[m];
+                size_t f = unit(rng) < EXCHANGE_SHARE ? string::npos : pickFood(candidate);
+                if (f == string::npos) {
+                    tryExchange(m, temperature, unit(rng));
+                    continue;
+                }
+                size_t removed = string::npos;
+                if (candidate.size() < size_t(p.opt.foodsPerMeal)) {
+                    candidate.push_back(f);
+                } else {
+                    size_t slot = randomIndex(candidate.size());
+                    removed = candidate[slot];
+                    candidate[slot] = f;
+                }
+
+                double miss;
+                evaluate(m, candidate, solution, miss);
+                double delta = miss - current.miss[m];
+                if (!accept(delta, temperature, unit(rng))) continue;
+
+                ++uses[f];
+                if (removed != string::npos) --uses[removed];
+                current.chosen[m].swap(candidate);
+                swap(current.solved[m], solution);
+                current.score += delta;
+                current.miss[m] = miss;
+                if (current.score < best.score) best = current;
+            }
+        }
+
+        static bool accept(double delta, double temperature, double u) {
+            return delta <= 0 || (temperature > 0 && u < exp(-delta / temperature));
+        }
+
+        // Trade one food of meal a for one of a random other meal
+        void tryExchange(size_t a, double temperature, double u) {
+            size_t b = randomIndex(p.meals);
+            vector<size_t>& ca = current.chosen[a];
+            vector<size_t>& cb = current.chosen[b];
+            if (a == b || ca.empty() || cb.empty()) return;
+            size_t ia = randomIndex(ca.size()), ib = randomIndex(cb.size());
+            size_t fa = ca[ia], fb = cb[ib];
+            if (find(ca.begin(), ca.end(), fb) != ca.end() || find(cb.begin(), cb.end(), fa) != cb.end()) return;
+
+            vector<size_t> na = ca, nb = cb;
+            na[ia] = fb;
+            nb[ib] = fa;
+            MealSolution sa, sb;
+            double ma, mb;
+            evaluate(a, na, sa, ma);
+            evaluate(b, nb, sb, mb);
+            double delta = (ma - current.miss[a]) + (mb - current.miss[b]);
+            if (!accept(delta, temperature, u)) return;
+
+            ca.swap(na);
+            cb.swap(nb);
+            swap(current.solved[a], sa);
+            swap(current.solved[b], sb);
+            current.miss[a] = ma;
+            current.miss[b] = mb;
+            current.score += delta;
+            if (current.score < best.score) best = current;
+        }
+    };
+
+    vector<MacroPlan> slotTargets(const MacroPlan& daily, const vector<MealSlot>& meals) {
+        double total = 0.0;
+        for (const auto& meal : meals) total += max(0.0, meal.share);
+        vector<MacroPlan> out;
+        for (const auto& meal : meals) {
+            double share = total > 0 ? max(0.0, meal.share) / total : 1.0 / meals.size();
+            out.push_back({ daily.calories * share, daily.protein_g * share,
+                            daily.fat_g * share, daily.carbs_g * share });
+        }
+        return out;
+    }
+}
+
+WeeklyPlan generateWeeklyPlan(const FoodTable& foods, const MacroPlan& daily, const WeeklyPlanOptions& opt) {
+    WeeklyPlan plan;
+    if (foods.empty() || opt.meals.empty() || opt.days <= 0 || opt.foodsPerMeal <= 0 || opt.maxRepeats <= 0)
+        return plan;
+
+    NutrientMatrix matrix;
+    matrix.assign(foods);
+
+    Problem p(matrix, opt);
+    p.slotTargets = slotTargets(daily, opt.meals);
+    p.slots    = opt.meals.size();
+    p.meals    = p.slots * size_t(opt.days);
+    p.start    = Clock::now();
+    p.deadline = p.start + chrono::milliseconds(max(0, opt.timeBudgetMs));
+
+    // This thread plus whatever helpers the shared budget can spare
+    unsigned wanted = min(opt.threads ? opt.threads : PlanWorkerLease::defaultThreads(), MAX_REQUEST_THREADS);
+    PlanWorkerLease helpers(max(1u, wanted) - 1);
+    unsigned threads = 1 + helpers.count();
+
+    vector<Worker> workers;
+    workers.reserve(threads);
+    for (unsigned w = 0; w < threads; ++w) workers.emplace_back(p, opt.seed + w);
+    vector<thread> pool;
+    for (unsigned w = 1; w < threads; ++w) pool.emplace_back([&workers, w] { workers[w].run(); });
+    workers[0].run();
+    for (auto& t : pool) t.join();
+
+    const Worker* winner = &workers[0];
+    for (const auto& w : workers) {
+        plan.evaluated += w.evaluated;
+        if (w.best.score < winner->best.score) winner = &w;
+    }
+    const State& best = winner->best;
+
+    plan.threads = threads;
+    plan.score   = best.score;
+    plan.withinTolerance = true;
+    vector<GroceryItem> groceries(foods.size());
+    for (size_t f = 0; f < foods.size(); ++f) groceries[f] = { f, 0.0, 0 };
+    for (size_t m = 0; m < p.meals; ++m) {
+        const MealSolution& s = best.solved[m];
+        plan.meals.push_back({ int(m / p.slots), m % p.slots, s.portions, p.target(m), s.totals });
+        plan.withinTolerance = plan.withinTolerance && s.withinTolerance;
+        for (const auto& portion : s.portions) {
+            groceries[portion.food].grams += portion.grams;
+            ++groceries[portion.food].meals;
+        }
+    }
+
+    for (const auto& g : groceries) {
+        if (g.grams > 0) plan.groceries.push_back(g);
+    }
+    sort(plan.groceries.begin(), plan.groceries.end(),
+         [](const GroceryItem& a, const GroceryItem& b) { return a.grams > b.grams; });
+    return plan;
+}
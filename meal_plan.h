@@ -0,0 +1,63 @@
+#ifndef MEAL_PLAN_H
+#define MEAL_PLAN_H
+
+#include <string>
+#include <vector>
+#include "food_api.h"
+#include "meal_solver.h"
+#include "planner.h"
+
+// Request limits for generateWeeklyPlan callers
+const int MAX_PLAN_DAYS           = 28;
+const int MAX_PLAN_TIME_BUDGET_MS = 5000;
+
+// One meal of the day and its share of the daily targets
+struct MealSlot {
+    std::string name;
+    double share;   // fraction of every daily macro; shares are normalised to sum to 1
+};
+
+struct WeeklyPlanOptions {
+    int days = 7;
+    std::vector<MealSlot> meals = { {"breakfast", 0.25}, {"lunch", 0.35}, {"dinner", 0.30}, {"snack", 0.10} };
+    int foodsPerMeal = 3;     // candidate foods per meal; the solver may leave some at 0 g
+    int maxRepeats   = 3;     // meals per week any one food may appear in
+    int timeBudgetMs = 200;   // wall-clock budget for the whole search
+    unsigned threads = 0;     // 0 = the default; never more than MAX_REQUEST_THREADS,
+                              // and only as many as the shared worker budget has free
+    unsigned seed    = 1;     // worker w searches with seed + w
+    MealSolverOptions solver;
+};
+
+struct PlannedMeal {
+    int    day;
+    size_t slot;                        // index into WeeklyPlanOptions::meals
+    std::vector<MealPortion> portions;  // food indexes the candidate list
+    MacroPlan target = {};
+    MacroPlan totals = {};
+};
+
+struct GroceryItem {
+    size_t food;    // index into the candidate list
+    double grams;   // summed over the week
+    int    meals;   // meals it appears in
+};
+
+struct WeeklyPlan {
+    std::vector<PlannedMeal> meals;     // day-major, slot-minor
+    std::vector<GroceryItem> groceries; // most grams first
+    double score = 0.0;                 // summed macroMiss over meals, lower is better
+    bool   withinTolerance = false;     // every meal within the solver tolerance
+    size_t evaluated = 0;               // meal solves across all workers
+    unsigned threads = 0;               // workers the search actually ran on
+};
+
+// Splits the daily targets across days x meals and picks foods for each meal
+// with randomized local search (simulated annealing over single food swaps),
+// one independent search per worker thread. Stops when the time budget runs
+// out and returns the best plan any worker found. No food appears in more than
+// maxRepeats meals; if the pool is too small for that, some meals get fewer foods.
+WeeklyPlan generateWeeklyPlan(const FoodTable& foods, const MacroPlan& daily,
+                              const WeeklyPlanOptions& opt = WeeklyPlanOptions());
+
+#endif
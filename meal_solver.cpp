@@ -0,0 +1,250 @@
+// meal_solver.cpp
+#include "meal_solver.h"
+#include "plan_kernel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+void NutrientMatrix::assign(const vector<FoodItem>& items) {
+    foods = items.size();
+    for (auto& row : perGram) row.assign(foods, 0.0);
+
+    auto clean = [](double per100g) { return (isfinite(per100g) && per100g > 0) ? per100g / 100.0 : 0.0; };
+    for (size_t j = 0; j < foods; ++j) {
+        perGram[MACRO_KCAL][j]    = clean(items[j].calories);
+        perGram[MACRO_PROTEIN][j] = clean(items[j].protein_g);
+        perGram[MACRO_FAT][j]     = clean(items[j].fat_g);
+        perGram[MACRO_CARBS][j]   = clean(items[j].carbs_g);
+    }
+}
+
+void NutrientMatrix::assign(const FoodTable& table) {
+    foods = table.size();
+    const Nutrient source[MACRO_ROWS] = { NUTRIENT_KCAL, NUTRIENT_PROTEIN, NUTRIENT_FAT, NUTRIENT_CARBS };
+
+    // One table column per matrix row, so each row is a single streaming pass
+    for (int r = 0; r < MACRO_ROWS; ++r) {
+        perGram[r].resize(foods);
+        for (size_t j = 0; j < foods; ++j) {
+            double per100g = table.amount(j, source[r]);
+            perGram[r][j] = (isfinite(per100g) && per100g > 0) ? per100g / 100.0 : 0.0;
+        }
+    }
+}
+
+MacroPlan macroTargets(double calories, double protein_g) {
+    double fat_kcal = calories * FAT_CALORIE_FRACTION;
+    double carbs_g  = max(0.0, calories - protein_g * KCAL_PER_G_PROTEIN - fat_kcal) / KCAL_PER_G_CARB;
+    return { calories, protein_g, fat_kcal / KCAL_PER_G_FAT, carbs_g };
+}
+
+namespace {
+    const int    M   = MACRO_ROWS;
+    static_assert(MACRO_ROWS == 4, "price() unrolls one row per macro");
+    const double EPS = 1e-12;
+    const double INF = numeric_limits<double>::infinity();
+
+    enum VarState : unsigned char { AT_LOWER, AT_UPPER, BASIC };
+
+    // Variables are the n foods, then M "under" slacks (+e_i), then M "over"
+    // slacks (-e_i). Only the slacks carry cost: w_i per unit of miss.
+    // Food j is matrix column cols[j], or column j when cols is null.
+    struct Simplex {
+        const NutrientMatrix& m;
+        const size_t* cols;
+        size_t n;
+        double upperFood;
+        double w[M];
+
+        vector<unsigned char> state;
+        vector<double>        reduced;   // scratch for pricing the food columns
+        size_t basis[M];
+        double xB[M];
+        double Binv[M][M];
+
+        Simplex(const NutrientMatrix& matrix, const size_t* columns, size_t count,
+                const double target[M], const double weight[M], double maxGrams)
+            : m(matrix), cols(columns), n(count), upperFood(maxGrams), state(count + 2 * M, AT_LOWER),
+              reduced(count) {
+            // Start with every food at zero and the "under" slacks covering the targets
+            for (int i = 0; i < M; ++i) {
+                w[i]        = weight[i];
+                basis[i]    = n + i;
+                xB[i]       = target[i];
+                state[n + i] = BASIC;
+                for (int k = 0; k < M; ++k) Binv[i][k] = (i == k) ? 1.0 : 0.0;
+            }
+        }
+
+        double cost(size_t j) const { return j < n ? 0.0 : w[(j - n) % M]; }
+        double upper(size_t j) const { return j < n ? upperFood : INF; }
+
+        void column(size_t j, double a[M]) const {
+            if (j < n) {
+                size_t c = cols ? cols[j] : j;
+                for (int i = 0; i < M; ++i) a[i] = m.perGram[i][c];
+            } else {
+                size_t s = j - n;
+                for (int i = 0; i < M; ++i) a[i] = 0.0;
+                a[s % M] = (s < size_t(M)) ? 1.0 : -1.0;
+            }
+        }
+
+        // Most attractive entering variable (Dantzig), or the lowest-index one
+        // (Bland) once the solve looks stuck on a degenerate vertex.
+        bool price(bool bland, size_t& q) {
+            double y[M];
+            for (int k = 0; k < M; ++k) {
+                y[k] = 0.0;
+                for (int i = 0; i < M; ++i) y[k] += cost(basis[i]) * Binv[i][k];
+            }
+
+            const double* r0 = m.perGram[0].data();
+            const double* r1 = m.perGram[1].data();
+            const double* r2 = m.perGram[2].data();
+            const double* r3 = m.perGram[3].data();
+            double* d = reduced.data();
+            if (cols) {
+                for (size_t j = 0; j < n; ++j) {
+                    size_t c = cols[j];
+                    d[j] = -(y[0] * r0[c] + y[1] * r1[c] + y[2] * r2[c] + y[3] * r3[c]);
+                }
+            } else {
+                for (size_t j = 0; j < n; ++j) d[j] = -(y[0] * r0[j] + y[1] * r1[j] + y[2] * r2[j] + y[3] * r3[j]);
+            }
+
+            double best = EPS;
+            bool found = false;
+            auto consider = [&](size_t j, double dj) {
+                double gain = state[j] == AT_LOWER ? -dj : (state[j] == AT_UPPER ? dj : 0.0);
+                if (gain > best) {
+                    best  = bland ? INF : gain;
+                    q     = j;
+                    found = true;
+                }
+            };
+            for (size_t j = 0; j < n && !(bland && found); ++j) consider(j, d[j]);
+            for (int i = 0; i < M && !(bland && found); ++i) {
+                consider(n + i,     w[i] - y[i]);
+                consider(n + M + i, w[i] + y[i]);
+            }
+            return found;
+        }
+
+        // One simplex step on entering variable q. Returns the step length.
+        double step(size_t q) {
+            double a[M], alpha[M];
+            column(q, a);
+            for (int i = 0; i < M; ++i) {
+                alpha[i] = 0.0;
+                for (int k = 0; k < M; ++k) alpha[i] += Binv[i][k] * a[k];
+            }
+
+            const double dir = state[q] == AT_LOWER ? 1.0 : -1.0;
+            double theta = upper(q);
+            int    leave = -1;
+            bool   leaveToUpper = false;
+            for (int i = 0; i < M; ++i) {
+                double rate = dir * alpha[i];  // basic i moves by -theta * rate
+                if (rate > EPS) {
+                    double limit = xB[i] / rate;
+                    if (limit < theta) { theta = limit; leave = i; leaveToUpper = false; }
+                } else if (rate < -EPS && upper(basis[i]) < INF) {
+                    double limit = (upper(basis[i]) - xB[i]) / -rate;
+                    if (limit < theta) { theta = limit; leave = i; leaveToUpper = true; }
+                }
+            }
+            theta = max(theta, 0.0);
+
+            for (int i = 0; i < M; ++i) xB[i] -= theta * dir * alpha[i];
+
+            if (leave < 0) {
+                // Bound flip: q crosses to its other bound, basis unchanged
+                state[q] = dir > 0 ? AT_UPPER : AT_LOWER;
+                return theta;
+            }
+
+            state[basis[leave]] = leaveToUpper ? AT_UPPER : AT_LOWER;
+            state[q]     = BASIC;
+            basis[leave] = q;
+            xB[leave]    = dir > 0 ? theta : upper(q) - theta;
+
+            double pivot = alpha[leave];
+            for (int k = 0; k < M; ++k) Binv[leave][k] /= pivot;
+            for (int i = 0; i < M; ++i) {
+                if (i == leave || alpha[i] == 0.0) continue;
+                for (int k = 0; k < M; ++k) Binv[i][k] -= alpha[i] * Binv[leave][k];
+            }
+            return theta;
+        }
+
+        double grams(size_t j) const {
+            if (state[j] == AT_UPPER) return upper(j);
+            if (state[j] == BASIC) {
+                for (int i = 0; i < M; ++i)
+                    if (basis[i] == j) return max(0.0, xB[i]);
+            }
+            return 0.0;
+        }
+    };
+}
+
+namespace {
+    MealSolution solve(const NutrientMatrix& m, const size_t* cols, size_t count, const MacroPlan& target,
+                       const MealSolverOptions& opt) {
+        MealSolution out;
+        const double t[M] = { max(0.0, target.calories), max(0.0, target.protein_g),
+                              max(0.0, target.fat_g), max(0.0, target.carbs_g) };
+        if (count == 0 || !(target.calories > 0)) return out;
+
+        // Relative misses, with calories counted double so they are matched first
+        double w[M];
+        for (int i = 0; i < M; ++i) w[i] = (i == MACRO_KCAL ? 2.0 : 1.0) / max(t[i], 1.0);
+
+        Simplex lp(m, cols, count, t, w, opt.maxGramsPerFood);
+        int stalled = 0;
+        size_t q = 0;
+        while (out.iterations < opt.maxIterations && lp.price(stalled > 8, q)) {
+            ++out.iterations;
+            stalled = lp.step(q) > EPS ? 0 : stalled + 1;
+        }
+
+        for (size_t j = 0; j < count; ++j) {
+            double g = lp.grams(j);
+            if (opt.gramStep > 0) g = round(g / opt.gramStep) * opt.gramStep;
+            if (g > 0) out.portions.push_back({ cols ? cols[j] : j, g });
+        }
+        sort(out.portions.begin(), out.portions.end(),
+             [](const MealPortion& a, const MealPortion& b) { return a.grams > b.grams; });
+
+        double sum[M] = {};
+        for (const auto& p : out.portions)
+            for (int i = 0; i < M; ++i) sum[i] += m.perGram[i][p.food] * p.grams;
+        out.totals = { sum[MACRO_KCAL], sum[MACRO_PROTEIN], sum[MACRO_FAT], sum[MACRO_CARBS] };
+
+        out.withinTolerance = true;
+        for (int i = 0; i < M; ++i) {
+            if (fabs(sum[i] - t[i]) > opt.tolerance * max(t[i], 1.0)) out.withinTolerance = false;
+        }
+        return out;
+    }
+}
+
+MealSolution solveMeal(const NutrientMatrix& m, const MacroPlan& target, const MealSolverOptions& opt) {
+    return solve(m, nullptr, m.foods, target, opt);
+}
+
+MealSolution solveMeal(const NutrientMatrix& m, const std::vector<size_t>& foods, const MacroPlan& target,
+                       const MealSolverOptions& opt) {
+    return solve(m, foods.data(), foods.size(), target, opt);
+}
+
+double macroMiss(const MacroPlan& totals, const MacroPlan& target) {
+    const double got[M]  = { totals.calories, totals.protein_g, totals.fat_g, totals.carbs_g };
+    const double want[M] = { target.calories, target.protein_g, target.fat_g, target.carbs_g };
+    double miss = 0.0;
+    for (int i = 0; i < M; ++i) miss += (i == MACRO_KCAL ? 2.0 : 1.0) * fabs(got[i] - want[i]) / max(want[i], 1.0);
+    return miss;
+}
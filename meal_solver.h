@@ -0,0 +1,60 @@
+#ifndef MEAL_SOLVER_H
+#define MEAL_SOLVER_H
+
+#include <vector>
+#include "food_api.h"
+#include "planner.h"
+
+// Nutrients the solver matches, in NutrientMatrix row order
+enum MacroRow { MACRO_KCAL, MACRO_PROTEIN, MACRO_FAT, MACRO_CARBS, MACRO_ROWS };
+
+// Per-gram nutrient values for a list of candidate foods. Each nutrient is one
+// contiguous row, so pricing every food against the targets is a straight
+// streaming pass over MACRO_ROWS arrays.
+struct NutrientMatrix {
+    size_t foods = 0;
+    std::vector<double> perGram[MACRO_ROWS];
+
+    // FoodItem nutrients are per 100 g; negative or non-finite values count as 0
+    void assign(const std::vector<FoodItem>& items);
+    void assign(const FoodTable& table);
+};
+
+struct MealSolverOptions {
+    double maxGramsPerFood = 300.0;
+    double gramStep        = 5.0;   // portions are rounded to this; 0 keeps the exact LP amounts
+    double tolerance       = 0.05;  // allowed relative miss per macro
+    int    maxIterations   = 500;
+};
+
+struct MealPortion {
+    size_t food;   // index into the candidate list
+    double grams;
+};
+
+struct MealSolution {
+    std::vector<MealPortion> portions;   // largest first
+    MacroPlan totals = {};
+    bool      withinTolerance = false;
+    int       iterations = 0;
+};
+
+// Bounded LP: choose 0 <= grams <= maxGramsPerFood for each candidate to minimise
+// the summed relative miss on calories, protein, fat and carbs. Solved with a
+// bounded-variable simplex whose basis is only MACRO_ROWS wide, so each iteration
+// costs one pass over the matrix.
+MealSolution solveMeal(const NutrientMatrix& m, const MacroPlan& target,
+                       const MealSolverOptions& opt = MealSolverOptions());
+
+// Same, restricted to the listed matrix columns (portions still index the matrix)
+MealSolution solveMeal(const NutrientMatrix& m, const std::vector<size_t>& foods, const MacroPlan& target,
+                       const MealSolverOptions& opt = MealSolverOptions());
+
+// The solver's objective for a finished meal: summed relative miss per macro,
+// calories counted double. 0 is a perfect hit.
+double macroMiss(const MacroPlan& totals, const MacroPlan& target);
+
+// Calories and protein -> full MacroPlan, splitting the rest as the planner does
+MacroPlan macroTargets(double calories, double protein_g);
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef NUTRIENTS_H
+#define NUTRIENTS_H
+
+#include <cstdint>
+#include <string_view>
+
+// Nutrients a FoodItem carries, by slot. The first four are the macros that
+// FoodItem also has as named fields.
+enum Nutrient : uint8_t {
+    NUTRIENT_KCAL, NUTRIENT_PROTEIN, NUTRIENT_CARBS, NUTRIENT_FAT,
+    NUTRIENT_FIBER, NUTRIENT_SUGARS, NUTRIENT_ADDED_SUGARS, NUTRIENT_SATURATED_FAT, NUTRIENT_TRANS_FAT,
+    NUTRIENT_CHOLESTEROL, NUTRIENT_SODIUM, NUTRIENT_POTASSIUM, NUTRIENT_CALCIUM, NUTRIENT_IRON,
+    NUTRIENT_VITAMIN_C, NUTRIENT_VITAMIN_D,
+    NUTRIENT_COUNT
+};
+
+// Amounts per 100 g by slot; 0 when the source reported none
+struct NutrientVector {
+    float value[NUTRIENT_COUNT] = {};
+
+    float  operator[](Nutrient n) const { return value[n]; }
+    float& operator[](Nutrient n) { return value[n]; }
+};
+
+// API name of each slot, unit included ("fiber_g", "sodium_mg")
+constexpr const char* NUTRIENT_KEYS[NUTRIENT_COUNT] = {
+    "calories", "protein_g", "carbs_g", "fat_g",
+    "fiber_g", "sugars_g", "added_sugars_g", "saturated_fat_g", "trans_fat_g",
+    "cholesterol_mg", "sodium_mg", "potassium_mg", "calcium_mg", "iron_mg",
+    "vitamin_c_mg", "vitamin_d_ug"
+};
+
+// A USDA nutrient that fills a slot. FDC identifies nutrients both by
+// nutrientId (1008) and by nutrientNumber ("208"); `number` is the latter
+// times ten plus its decimal digit ("205.2" -> 2052). Where several USDA
+// nutrients can fill a slot, lower rank wins: kcal prefers Energy (1008) over
+// the Atwater factors (2047, 2048), and Energy in kJ (1062) is not a source at
+// all, so it can no longer overwrite kcal.
+struct NutrientSource {
+    uint16_t id;
+    uint16_t number;
+    Nutrient slot;
+    uint8_t  rank;
+};
+
+constexpr NutrientSource NUTRIENT_SOURCES[] = {
+    { 1008, 2080, NUTRIENT_KCAL, 0 },          // Energy (KCAL)
+    { 2047, 9570, NUTRIENT_KCAL, 1 },          // Energy (Atwater General Factors)
+    { 2048, 9580, NUTRIENT_KCAL, 2 },          // Energy (Atwater Specific Factors)
+    { 1003, 2030, NUTRIENT_PROTEIN, 0 },
+    { 1005, 2050, NUTRIENT_CARBS, 0 },         // by difference
+    { 1050, 2052, NUTRIENT_CARBS, 1 },         // by summation
+    { 1004, 2040, NUTRIENT_FAT, 0 },           // Total lipid (fat)
+    { 1079, 2910, NUTRIENT_FIBER, 0 },         // Fiber, total dietary
+    { 2000, 2690, NUTRIENT_SUGARS, 0 },        // Sugars, total including NLEA
+    { 1063, 2693, NUTRIENT_SUGARS, 1 },        // Sugars, Total
+    { 1235, 5390, NUTRIENT_ADDED_SUGARS, 0 },
+    { 1258, 6060, NUTRIENT_SATURATED_FAT, 0 },
+    { 1257, 6050, NUTRIENT_TRANS_FAT, 0 },
+    { 1253, 6010, NUTRIENT_CHOLESTEROL, 0 },
+    { 1093, 3070, NUTRIENT_SODIUM, 0 },
+    { 1092, 3060, NUTRIENT_POTASSIUM, 0 },
+    { 1087, 3010, NUTRIENT_CALCIUM, 0 },
+    { 1089, 3030, NUTRIENT_IRON, 0 },
+    { 1162, 4010, NUTRIENT_VITAMIN_C, 0 },     // total ascorbic acid
+    { 1114, 3280, NUTRIENT_VITAMIN_D, 0 },     // D2 + D3, ug
+};
+constexpr size_t NUTRIENT_SOURCE_COUNT = sizeof(NUTRIENT_SOURCES) / sizeof(NUTRIENT_SOURCES[0]);
+
+// Compile-time perfect hashes from nutrientId and from nutrientNumber to a
+// NUTRIENT_SOURCES entry: bucket = (key * multiplier) >> (32 - bits), with the
+// multiplier searched at compile time so that no two sources share a bucket.
+// A lookup is a multiply, a shift, one table load and one compare.
+namespace nutrient_hash {
+    constexpr unsigned BITS = 7;
+    constexpr unsigned BUCKETS = 1u << BITS;
+    static_assert(NUTRIENT_SOURCE_COUNT <= BUCKETS, "grow BITS");
+
+    constexpr unsigned bucket(uint32_t key, uint32_t multiplier) {
+        return uint32_t(key * multiplier) >> (32 - BITS);
+    }
+
+    constexpr uint32_t keyOf(const NutrientSource& s, bool byNumber) { return byNumber ? s.number : s.id; }
+
+    constexpr bool collisionFree(uint32_t multiplier, bool byNumber) {
+        bool used[BUCKETS] = {};
+        for (const auto& s : NUTRIENT_SOURCES) {
+            unsigned b = bucket(keyOf(s, byNumber), multiplier);
+            if (used[b]) return false;
+            used[b] = true;
+        }
+        return true;
+    }
+
+    constexpr uint32_t findMultiplier(bool byNumber) {
+        // Odd multipliers along an LCG sequence, starting from the golden ratio
+        for (uint32_t m = 0x9E3779B1u;; m = (m * 1664525u + 1013904223u) | 1u)
+            if (collisionFree(m, byNumber)) return m;
+    }
+
+    struct Table {
+        uint32_t multiplier;
+        int8_t   entry[BUCKETS];   // index into NUTRIENT_SOURCES, or -1
+    };
+
+    constexpr Table build(bool byNumber) {
+        Table t = { findMultiplier(byNumber), {} };
+        for (auto& e : t.entry) e = -1;
+        for (size_t i = 0; i < NUTRIENT_SOURCE_COUNT; ++i)
+            t.entry[bucket(keyOf(NUTRIENT_SOURCES[i], byNumber), t.multiplier)] = int8_t(i);
+        return t;
+    }
+
+    constexpr Table BY_ID = build(false);
+    constexpr Table BY_NUMBER = build(true);
+
+    constexpr const NutrientSource* find(const Table& t, uint32_t key, bool byNumber) {
+        int e = t.entry[bucket(key, t.multiplier)];
+        return (e >= 0 && keyOf(NUTRIENT_SOURCES[e], byNumber) == key) ? &NUTRIENT_SOURCES[e] : nullptr;
+    }
+}
+
+// The source for a USDA nutrientId, or nullptr for nutrients we do not keep
+constexpr const NutrientSource* nutrientById(int id) {
+    return id > 0 && id <= 0xffff ? nutrient_hash::find(nutrient_hash::BY_ID, uint32_t(id), false) : nullptr;
+}
+
+// "208" -> 2080, "205.2" -> 2052; -1 when malformed
+constexpr int nutrientNumberCode(std::string_view s) {
+    int whole = 0, tenth = 0;
+    size_t i = 0;
+    for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        whole = whole * 10 + (s[i] - '0');
+        if (whole > 6000) return -1;
+    }
+    if (i == 0) return -1;
+    if (i < s.size()) {
+        if (s[i] != '.' || i + 2 != s.size() || s[i + 1] < '0' || s[i + 1] > '9') return -1;
+        tenth = s[i + 1] - '0';
+    }
+    return whole * 10 + tenth;
+}
+
+// The source for a USDA nutrientNumber, or nullptr
+constexpr const NutrientSource* nutrientByNumber(std::string_view number) {
+    int code = nutrientNumberCode(number);
+    return code >= 0 ? nutrient_hash::find(nutrient_hash::BY_NUMBER, uint32_t(code), true) : nullptr;
+}
+
+static_assert(nutrientById(1008)->slot == NUTRIENT_KCAL, "nutrient id hash");
+static_assert(!nutrientById(1062), "kJ energy must not map to a slot");
+static_assert(nutrientByNumber("205.2")->slot == NUTRIENT_CARBS, "nutrient number hash");
+static_assert(!nutrientByNumber("268"), "kJ energy must not map to a slot");
+
+// Folds one food's nutrient list into per-slot amounts, keeping the
+// best-ranked source per slot whatever order the entries come in
+struct NutrientCollector {
+    double  amount[NUTRIENT_COUNT];
+    uint8_t rank[NUTRIENT_COUNT];
+
+    NutrientCollector() { reset(); }
+
+    void reset() {
+        for (auto& a : amount) a = 0.0;
+        for (auto& r : rank) r = UINT8_MAX;
+    }
+
+    void offer(const NutrientSource* source, double value) {
+        if (!source || source->rank >= rank[source->slot]) return;
+        rank[source->slot] = source->rank;
+        amount[source->slot] = value;
+    }
+};
+
+#endif
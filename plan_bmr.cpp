@@ -0,0 +1,119 @@
+// plan_bmr.cpp
+// Every BMR formula for every row in a single pass, for side-by-side views.
+// The activity/goal/pace factors and the inputs are gathered once per block and
+// shared; only the BMR line differs per formula, and its constants fold in at
+// compile time.
+#include "planner.h"
+#include "plan_kernel.h"
+#include "plan_simd.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+    typedef Simd<double>::vec vdouble;
+    const size_t LANES = Simd<double>::LANES;
+
+    struct Block {
+        Column<double> male, kg, cm, age, lean;
+        Column<double> tdeeFactor, adjustPerKg, floorScale, floorOffset;
+    };
+
+    struct Lanes {
+        vdouble male, kg, cm, age, lean;
+        vdouble tdeeFactor, adjustPerKg, floorScale, floorOffset;
+    };
+
+    void loadLanesFor(Lanes& v, const Block& b, size_t r) {
+        loadLanes<double>(v.male,        b.male,        r);
+        loadLanes<double>(v.kg,          b.kg,          r);
+        loadLanes<double>(v.cm,          b.cm,          r);
+        loadLanes<double>(v.age,         b.age,         r);
+        loadLanes<double>(v.lean,        b.lean,        r);
+        loadLanes<double>(v.tdeeFactor,  b.tdeeFactor,  r);
+        loadLanes<double>(v.adjustPerKg, b.adjustPerKg, r);
+        loadLanes<double>(v.floorScale,  b.floorScale,  r);
+        loadLanes<double>(v.floorOffset, b.floorOffset, r);
+    }
+
+    // Same steps as evalPlan from the BMR onwards, for one formula's columns
+    template <class Bmr>
+    void planFormula(BmrFormula formula, const Lanes& v, BmrComparison& out, size_t i, size_t count) {
+        const size_t f = static_cast<size_t>(formula);
+
+        vdouble bmr       = bmrBySex<Bmr>(v.male > 0.5, v.kg, v.cm, v.age, v.lean);
+        vdouble tdee      = v.tdeeFactor * bmr;
+        vdouble target    = v.adjustPerKg * v.kg + tdee;
+        vdouble floorKcal = v.floorScale * bmr + v.floorOffset;
+        target = (target < floorKcal) ? floorKcal : target;
+
+        storeLanes<double>(&out.bmr[f][i],            bmr,    count);
+        storeLanes<double>(&out.tdee[f][i],           tdee,   count);
+        storeLanes<double>(&out.targetCalories[f][i], target, count);
+    }
+
+    template <class Bmr>
+    void setStatus(BmrFormula formula, const vector<unsigned char>& base, const PlanBatchInput& in,
+                   BmrComparison& out) {
+        vector<unsigned char>& status = out.status[static_cast<size_t>(formula)];
+        status = base;
+        if constexpr (Bmr::USES_LEAN_MASS) {
+            for (size_t i = 0; i < status.size(); ++i) {
+                double bodyFat = i < in.bodyFatPct.size() ? in.bodyFatPct[i] : 0.0;
+                status[i] |= bodyFatStatus(bodyFat);
+            }
+        }
+    }
+}
+
+void compareBmrFormulas(const PlanBatchInput& in, BmrComparison& out) {
+    static_assert(BMR_FORMULA_COUNT == 4, "one planFormula call per BmrFormula");
+    const size_t n = in.size();
+
+    vector<unsigned char> base(n);
+    for (size_t i = 0; i < n; ++i) base[i] = planRangeStatus(in.weight[i], in.height[i], in.ageYears[i]);
+    setStatus<MifflinStJeor>(BmrFormula::MifflinStJeor, base, in, out);
+    setStatus<HarrisBenedict>(BmrFormula::HarrisBenedict, base, in, out);
+    setStatus<KatchMcArdle>(BmrFormula::KatchMcArdle, base, in, out);
+    setStatus<Cunningham>(BmrFormula::Cunningham, base, in, out);
+    for (size_t f = 0; f < BMR_FORMULA_COUNT; ++f) {
+        out.bmr[f].resize(n);
+        out.tdee[f].resize(n);
+        out.targetCalories[f].resize(n);
+    }
+
+    Block block;
+    Lanes v;
+    for (size_t start = 0; start < n; start += BLOCK_ROWS) {
+        size_t rows = min(BLOCK_ROWS, n - start);
+        for (size_t r = 0; r < rows; ++r) {
+            size_t i = start + r;
+            const PlanCoefficients& c = PLAN_TABLE[planTableSlot(in.sex[i], in.activity[i], in.goal[i], in.pace[i])];
+            double bodyFat = i < in.bodyFatPct.size() ? in.bodyFatPct[i] : 0.0;
+            block.male.v[r]        = in.sex[i] == Sex::Male ? 1.0 : 0.0;
+            block.kg.v[r]          = in.weight[i];
+            block.cm.v[r]          = in.height[i];
+            block.age.v[r]         = in.ageYears[i];
+            block.lean.v[r]        = leanMassKg(in.weight[i], bodyFat);
+            block.tdeeFactor.v[r]  = c.tdeeFactor;
+            block.adjustPerKg.v[r] = c.adjustPerKg;
+            block.floorScale.v[r]  = c.floorScale;
+            block.floorOffset.v[r] = c.floorOffset;
+        }
+
+        for (size_t r = 0; r < rows; r += LANES) {
+            size_t i = start + r, count = min(LANES, rows - r);
+            loadLanesFor(v, block, r);
+            planFormula<MifflinStJeor>(BmrFormula::MifflinStJeor, v, out, i, count);
+            planFormula<HarrisBenedict>(BmrFormula::HarrisBenedict, v, out, i, count);
+            planFormula<KatchMcArdle>(BmrFormula::KatchMcArdle, v, out, i, count);
+            planFormula<Cunningham>(BmrFormula::Cunningham, v, out, i, count);
+        }
+    }
+
+    for (size_t f = 0; f < BMR_FORMULA_COUNT; ++f) {
+        for (size_t i = 0; i < n; ++i) {
+            if (out.status[f][i] != PLAN_OK) out.bmr[f][i] = out.tdee[f][i] = out.targetCalories[f][i] = 0.0;
+        }
+    }
+}
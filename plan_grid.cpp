@@ -0,0 +1,129 @@
+// plan_grid.cpp
+#include "plan_grid.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+size_t GridAxis::count() const {
+    if (!(step > 0.0) || to <= from) return 1;
+    // Small tolerance so 15..120 step 0.1 includes 120
+    double n = floor((to - from) / step + 1e-9) + 1.0;
+    return n > double(MAX_GRID_ROWS) ? MAX_GRID_ROWS + 1 : size_t(n);
+}
+
+size_t PlanGrid::size() const {
+    const size_t dims[] = { sexes.size(), age.count(), height.count(), weight.count(),
+                            activities.size(), goals.size(), paces.size() };
+    size_t total = 1;
+    for (size_t d : dims) {
+        if (d == 0) return 0;
+        if (total > (MAX_GRID_ROWS + 1) / d) return MAX_GRID_ROWS + 1;
+        total *= d;
+    }
+    return total;
+}
+
+void PlanGrid::fill(size_t first, size_t count, PlanBatchInput& out) const {
+    // Mixed-radix odometer, most significant digit first
+    const size_t radix[7] = { sexes.size(), age.count(), height.count(), weight.count(),
+                              activities.size(), goals.size(), paces.size() };
+    size_t digit[7];
+    size_t rest = first;
+    for (int d = 6; d >= 0; --d) {
+        digit[d] = rest % radix[d];
+        rest /= radix[d];
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        UserInput u;
+        u.units    = Units::Metric;
+        u.sex      = sexes[digit[0]];
+        u.ageYears = int(lround(age.at(digit[1])));
+        u.height   = height.at(digit[2]);
+        u.weight   = weight.at(digit[3]);
+        u.activity = activities[digit[4]];
+        u.goal     = goals[digit[5]];
+        u.pace     = paces[digit[6]];
+        out.push_back(u);
+
+        for (int d = 6; d >= 0; --d) {
+            if (++digit[d] < radix[d]) break;
+            digit[d] = 0;
+        }
+    }
+}
+
+PlanGridSweep::PlanGridSweep(PlanGrid grid, Formatter format, unsigned threads)
+    : grid_(move(grid)), format_(move(format)) {
+    size_t rows = grid_.size();
+    chunks_ = (rows + GRID_CHUNK_ROWS - 1) / GRID_CHUNK_ROWS;
+
+    // Workers come out of the shared budget; with none free, one still runs
+    if (threads == 0) threads = PlanWorkerLease::defaultThreads();
+    threads = unsigned(min<size_t>(min(threads, MAX_REQUEST_THREADS), max<size_t>(chunks_, 1)));
+    lease_.reset(new PlanWorkerLease(threads));
+    threads = max(1u, lease_->count());
+    window_ = size_t(threads) * 2;
+    slots_.resize(window_);
+
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back(&PlanGridSweep::worker, this);
+    }
+}
+
+PlanGridSweep::~PlanGridSweep() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    changed_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void PlanGridSweep::worker() {
+    PlanBatchInput  in;
+    PlanBatchResult out;
+    const size_t rows = grid_.size();
+
+    for (;;) {
+        size_t k;
+        {
+            unique_lock<mutex> lock(mutex_);
+            changed_.wait(lock, [&] { return stop_ || claimed_ >= chunks_ || claimed_ < emitted_ + window_; });
+            if (stop_ || claimed_ >= chunks_) return;
+            k = claimed_++;
+        }
+
+        size_t first = k * GRID_CHUNK_ROWS;
+        in.clear();
+        grid_.fill(first, min(GRID_CHUNK_ROWS, rows - first), in);
+        computePlanBatch(in, out);
+
+        string text;
+        format_(in, out, text);
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            Slot& slot = slots_[k % window_];
+            slot.text  = move(text);
+            slot.ready = true;
+        }
+        changed_.notify_all();
+    }
+}
+
+bool PlanGridSweep::next(string& chunk) {
+    unique_lock<mutex> lock(mutex_);
+    if (emitted_ >= chunks_) return false;
+
+    Slot& slot = slots_[emitted_ % window_];
+    changed_.wait(lock, [&] { return slot.ready; });
+    chunk = move(slot.text);
+    slot.text.clear();
+    slot.ready = false;
+    ++emitted_;
+    lock.unlock();
+    changed_.notify_all();
+    return true;
+}
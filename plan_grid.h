@@ -0,0 +1,84 @@
+// plan_grid.h
+// Cartesian-product sweeps of computePlanBatch over ranges of UserInput fields,
+// produced in parallel and consumed in order, chunk by chunk.
+#pragma once
+#include "planner.h"
+#include "plan_workers.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const size_t MAX_GRID_ROWS   = 100000000;
+const size_t GRID_CHUNK_ROWS = 1024;
+
+// Inclusive range from, from + step, ..., <= to. A single value has step 0.
+struct GridAxis {
+    double from = 0.0;
+    double to   = 0.0;
+    double step = 0.0;
+
+    size_t count() const;
+    double at(size_t i) const { return from + step * i; }
+};
+
+struct PlanGrid {
+    std::vector<Sex>      sexes;
+    GridAxis              age;
+    GridAxis              height; // cm
+    GridAxis              weight; // kg
+    std::vector<Activity> activities;
+    std::vector<Goal>     goals;
+    std::vector<Pace>     paces;
+
+    // Number of rows in the product, saturating at MAX_GRID_ROWS + 1.
+    size_t size() const;
+
+    // Appends rows [first, first + count) in sex, age, height, weight, activity,
+    // goal, pace order (pace varies fastest).
+    void fill(size_t first, size_t count, PlanBatchInput& out) const;
+};
+
+// Runs a PlanGrid through computePlanBatch on worker threads, GRID_CHUNK_ROWS
+// rows at a time, and hands back each chunk's formatted text in row order.
+// Workers stay at most a few chunks ahead of the consumer, so memory does not
+// grow with the grid size. At most MAX_REQUEST_THREADS workers, borrowed from
+// the PlanWorkerLease budget.
+class PlanGridSweep {
+public:
+    using Formatter = std::function<void(const PlanBatchInput&, const PlanBatchResult&, std::string&)>;
+
+    PlanGridSweep(PlanGrid grid, Formatter format, unsigned threads = 0);
+    ~PlanGridSweep();
+
+    PlanGridSweep(const PlanGridSweep&) = delete;
+    PlanGridSweep& operator=(const PlanGridSweep&) = delete;
+
+    // Blocks until the next chunk is ready; false once every chunk has been returned.
+    bool next(std::string& chunk);
+
+private:
+    struct Slot {
+        std::string text;
+        bool        ready = false;
+    };
+
+    void worker();
+
+    PlanGrid   grid_;
+    Formatter  format_;
+    size_t     chunks_;
+    size_t     window_;
+
+    std::mutex              mutex_;
+    std::condition_variable changed_;
+    std::vector<Slot>       slots_;      // chunk k lives in slots_[k % window_]
+    size_t                  claimed_ = 0;
+    size_t                  emitted_ = 0;
+    bool                    stop_    = false;
+    std::unique_ptr<PlanWorkerLease> lease_;   // returned after the workers are joined
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,233 @@
+// plan_kernel.h
+// Compile-time coefficient tables and the branch-free plan arithmetic shared by
+// computePlan (one user) and computePlanBatch (many users per SIMD register).
+#pragma once
+#include "planner.h"
+#include <array>
+#include <cstddef>
+#include <limits>
+
+constexpr double KCAL_PER_G_FAT         = 9.0;
+constexpr double KCAL_PER_G_PROTEIN     = 4.0;
+constexpr double KCAL_PER_G_CARB        = 4.0;
+constexpr double KCAL_PER_KG_FAT        = 7700.0;  // Approximation for body fat loss/gain
+constexpr double MIN_CALORIE_MULTIPLIER = 1.1;     // Minimum calories as % of BMR
+constexpr double FAT_CALORIE_FRACTION   = 0.25;    // Share of calories from fat
+constexpr double LB_PER_KG              = 2.20462;
+
+constexpr double activityFactor(Activity a) {
+    switch (a) {
+        case Activity::Sedentary: return 1.20;
+        case Activity::Light:     return 1.375;
+        case Activity::Moderate:  return 1.55;
+        case Activity::Very:      return 1.725;
+        case Activity::Extra:     return 1.90;
+        default:                  return 1.55;
+    }
+}
+
+constexpr double paceFraction(Pace p) {
+    switch (p) {
+        case Pace::Slow:       return 0.0025;  // 0.25%
+        case Pace::Normal:     return 0.0050;  // 0.5%
+        case Pace::Aggressive: return 0.0100;  // 1.0%
+        default:               return 0.0050;
+    }
+}
+
+constexpr double proteinPerKg(Goal goal) {
+    switch (goal) {
+        case Goal::Cut:      return 2.2;
+        case Goal::Maintain: return 1.8;
+        case Goal::Bulk:     return 1.6;
+        default:             return 1.8;
+    }
+}
+
+// Everything a plan needs for one Sex x Activity x Goal x Pace combination, folded
+// into linear coefficients. V is double for the table, or a SIMD vector when the
+// batch kernel gathers one entry per lane.
+template <class V>
+struct BasicPlanCoefficients {
+    V bmrKg, bmrCm, bmrAge, bmrConst;  // bmr = bmrKg*kg + bmrCm*cm + bmrAge*age + bmrConst
+    V bmrLeanKg;                       //       + bmrLeanKg*leanKg (lean-mass formulas only)
+    V tdeeFactor;                      // tdee = tdeeFactor * bmr
+    V adjustPerKg;                     // target = tdee + adjustPerKg * kg (signed daily kcal)
+    V floorScale, floorOffset;         // target >= floorScale * bmr + floorOffset (-inf when not cutting)
+    V weeklyPerKg;                     // weeklyChangeKg = weeklyPerKg * kg
+    V proteinPerKg;                    // protein_g = proteinPerKg * kg
+    V fatPerKcal;                      // fat_g = fatPerKcal * target
+    V carbsPerKcal, carbsPerProteinG;  // carbs_g = max(0, carbsPerKcal * target - carbsPerProteinG * protein_g)
+};
+
+using PlanCoefficients = BasicPlanCoefficients<double>;
+
+template <class Bmr = MifflinStJeor>
+constexpr PlanCoefficients makePlanCoefficients(Sex sex, Activity activity, Goal goal, Pace pace) {
+    const bool   cut    = goal == Goal::Cut;
+    const double sign   = cut ? -1.0 : (goal == Goal::Bulk ? 1.0 : 0.0);
+    const double weekly = (goal == Goal::Maintain) ? 0.0 : paceFraction(pace);
+    const BmrLinear bmr = Bmr::terms(sex);
+
+    PlanCoefficients c = {};
+    c.bmrKg            = bmr.perKg;
+    c.bmrCm            = bmr.perCm;
+    c.bmrAge           = bmr.perAge;
+    c.bmrConst         = bmr.constant;
+    c.bmrLeanKg        = bmr.perLeanKg;
+    c.tdeeFactor       = activityFactor(activity);
+    c.adjustPerKg      = sign * weekly * KCAL_PER_KG_FAT / 7.0;
+    c.floorScale       = cut ? MIN_CALORIE_MULTIPLIER : 0.0;
+    c.floorOffset      = cut ? 0.0 : -std::numeric_limits<double>::infinity();
+    c.weeklyPerKg      = weekly;
+    c.proteinPerKg     = proteinPerKg(goal);
+    c.fatPerKcal       = FAT_CALORIE_FRACTION / KCAL_PER_G_FAT;
+    c.carbsPerKcal     = (1.0 - FAT_CALORIE_FRACTION) / KCAL_PER_G_CARB;
+    c.carbsPerProteinG = KCAL_PER_G_PROTEIN / KCAL_PER_G_CARB;
+    return c;
+}
+
+constexpr size_t PLAN_SEXES      = 2;
+constexpr size_t PLAN_ACTIVITIES = 5;
+constexpr size_t PLAN_GOALS      = 3;
+constexpr size_t PLAN_PACES      = 3;
+constexpr size_t PLAN_TABLE_SIZE = PLAN_SEXES * PLAN_ACTIVITIES * PLAN_GOALS * PLAN_PACES;
+
+constexpr size_t planTableIndex(Sex sex, Activity activity, Goal goal, Pace pace) {
+    return ((static_cast<size_t>(sex) * PLAN_ACTIVITIES
+             + (static_cast<size_t>(activity) - 1)) * PLAN_GOALS
+             + static_cast<size_t>(goal)) * PLAN_PACES
+             + static_cast<size_t>(pace);
+}
+
+template <class Bmr>
+constexpr std::array<PlanCoefficients, PLAN_TABLE_SIZE> makePlanTable() {
+    std::array<PlanCoefficients, PLAN_TABLE_SIZE> table = {};
+    for (size_t s = 0; s < PLAN_SEXES; ++s)
+        for (size_t a = 0; a < PLAN_ACTIVITIES; ++a)
+            for (size_t g = 0; g < PLAN_GOALS; ++g)
+                for (size_t p = 0; p < PLAN_PACES; ++p) {
+                    Sex sex = static_cast<Sex>(s);
+                    Activity activity = static_cast<Activity>(a + 1);
+                    Goal goal = static_cast<Goal>(g);
+                    Pace pace = static_cast<Pace>(p);
+                    table[planTableIndex(sex, activity, goal, pace)] =
+                        makePlanCoefficients<Bmr>(sex, activity, goal, pace);
+                }
+    return table;
+}
+
+template <class Bmr>
+inline constexpr std::array<PlanCoefficients, PLAN_TABLE_SIZE> PLAN_TABLE_FOR = makePlanTable<Bmr>();
+
+inline constexpr const std::array<PlanCoefficients, PLAN_TABLE_SIZE>& PLAN_TABLE = PLAN_TABLE_FOR<MifflinStJeor>;
+
+static_assert(PLAN_TABLE_SIZE == 90, "one entry per Sex x Activity x Goal x Pace");
+static_assert(PLAN_TABLE[planTableIndex(Sex::Female, Activity::Extra, Goal::Bulk, Pace::Aggressive)].tdeeFactor == 1.90,
+              "table indexing must match planTableIndex");
+static_assert(PLAN_TABLE[planTableIndex(Sex::Male, Activity::Sedentary, Goal::Maintain, Pace::Slow)].adjustPerKg == 0.0,
+              "maintenance has no pace adjustment");
+
+// Runtime table index. Out-of-range enum values fall back to the same defaults as the switches above.
+inline size_t planTableSlot(Sex sex, Activity activity, Goal goal, Pace pace) {
+    if (static_cast<unsigned>(sex) >= PLAN_SEXES)               sex = Sex::Female;
+    if (static_cast<unsigned>(activity) - 1 >= PLAN_ACTIVITIES) activity = Activity::Moderate;
+    if (static_cast<unsigned>(goal) >= PLAN_GOALS)              goal = Goal::Maintain;
+    if (static_cast<unsigned>(pace) >= PLAN_PACES)              pace = Pace::Normal;
+    return planTableIndex(sex, activity, goal, pace);
+}
+
+template <class Bmr = MifflinStJeor>
+inline const PlanCoefficients& planCoefficients(Sex sex, Activity activity, Goal goal, Pace pace) {
+    return PLAN_TABLE_FOR<Bmr>[planTableSlot(sex, activity, goal, pace)];
+}
+
+// validateInput's range checks as PlanStatus bits.
+inline unsigned char planRangeStatus(double weight, double height, int ageYears) {
+    unsigned char status = PLAN_OK;
+    if (weight <= 0 || weight > 500)     status |= PLAN_BAD_WEIGHT;
+    if (height <= 0 || height > 300)     status |= PLAN_BAD_HEIGHT;
+    if (ageYears < MIN_AGE_YEARS || ageYears > MAX_AGE_YEARS) status |= PLAN_BAD_AGE;
+    return status;
+}
+
+inline unsigned char bodyFatStatus(double bodyFatPct) {
+    return (bodyFatPct <= 0 || bodyFatPct > 75) ? PLAN_BAD_BODY_FAT : PLAN_OK;
+}
+
+inline double leanMassKg(double kg, double bodyFatPct) {
+    return kg * (1.0 - bodyFatPct / 100.0);
+}
+
+constexpr Pace paceUsed(Goal goal, Pace pace) {
+    return (goal == Goal::Maintain) ? Pace::Normal : pace;
+}
+
+template <class V>
+struct PlanTerms {
+    V bmr, tdee, targetCalories, weeklyChangeKg, protein_g, fat_g, carbs_g;
+};
+
+// The whole plan as multiply-adds plus two clamps; no branches on the enums.
+// Works for V = double and for GCC/Clang vector types alike. Inputs are not validated.
+// c must come from PLAN_TABLE_FOR<Bmr>; leanKg is only read by lean-mass formulas.
+template <class Bmr, class V>
+inline void evalPlan(const BasicPlanCoefficients<V>& c, const V& kg, const V& cm, const V& age, const V& leanKg,
+                     PlanTerms<V>& t) {
+    const V zero = {};
+    t.bmr = c.bmrKg * kg + c.bmrCm * cm + c.bmrAge * age + c.bmrConst;
+    if constexpr (Bmr::USES_LEAN_MASS) t.bmr = c.bmrLeanKg * leanKg + t.bmr;
+    t.tdee = c.tdeeFactor * t.bmr;
+
+    V target    = c.adjustPerKg * kg + t.tdee;
+    V floorKcal = c.floorScale * t.bmr + c.floorOffset;
+    t.targetCalories = (target < floorKcal) ? floorKcal : target;
+    t.weeklyChangeKg = c.weeklyPerKg * kg;
+
+    t.protein_g = c.proteinPerKg * kg;
+    t.fat_g     = c.fatPerKcal * t.targetCalories;
+    V carbs     = c.carbsPerKcal * t.targetCalories - c.carbsPerProteinG * t.protein_g;
+    t.carbs_g   = (zero < carbs) ? carbs : zero;
+}
+
+template <class V>
+inline void evalPlan(const BasicPlanCoefficients<V>& c, const V& kg, const V& cm, const V& age, PlanTerms<V>& t) {
+    evalPlan<MifflinStJeor>(c, kg, cm, age, kg, t);
+}
+
+// BMR for formula Bmr with each lane's sex picked by the male mask (a bool, or a
+// vector compare result). Same operation order as evalPlan's BMR line.
+template <class Bmr, class V, class M>
+inline V bmrBySex(const M& male, const V& kg, const V& cm, const V& age, const V& leanKg) {
+    constexpr BmrLinear m = Bmr::terms(Sex::Male);
+    constexpr BmrLinear f = Bmr::terms(Sex::Female);
+    V bmrMale   = m.perKg * kg + m.perCm * cm + m.perAge * age + m.constant;
+    V bmrFemale = f.perKg * kg + f.perCm * cm + f.perAge * age + f.constant;
+    if constexpr (Bmr::USES_LEAN_MASS) {
+        bmrMale   = m.perLeanKg * leanKg + bmrMale;
+        bmrFemale = f.perLeanKg * leanKg + bmrFemale;
+    }
+    return male ? bmrMale : bmrFemale;
+}
+
+inline PlanResult planResultFrom(const PlanTerms<double>& t, Pace used) {
+    PlanResult r;
+    r.bmr            = t.bmr;
+    r.tdee           = t.tdee;
+    r.targetCalories = t.targetCalories;
+    r.weeklyChangeKg = t.weeklyChangeKg;
+    r.weeklyChangeLb = t.weeklyChangeKg * LB_PER_KG;
+    r.paceUsed       = used;
+    r.macros         = { t.targetCalories, t.protein_g, t.fat_g, t.carbs_g };
+    return r;
+}
+
+// Plan for a combination fixed at compile time; the coefficients fold into constants.
+template <Sex S, Activity A, Goal G, Pace P>
+PlanResult computePlanFor(double kg, double cm, int ageYears) {
+    constexpr PlanCoefficients c = makePlanCoefficients(S, A, G, P);
+    const double age = ageYears;
+    PlanTerms<double> t;
+    evalPlan(c, kg, cm, age, t);
+    return planResultFrom(t, paceUsed(G, P));
+}
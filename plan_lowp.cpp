@@ -0,0 +1,224 @@
+// plan_lowp.cpp
+// Single-precision and int32 fixed-point batch planners. See planner.h for the
+// fixed-point units and bench/plan_accuracy.cpp for measured error.
+#include "planner.h"
+#include "plan_kernel.h"
+#include "plan_simd.h"
+#include <array>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // --- float ---
+
+    constexpr BasicPlanCoefficients<float> toFloat(const PlanCoefficients& c) {
+        return { float(c.bmrKg), float(c.bmrCm), float(c.bmrAge), float(c.bmrConst), float(c.bmrLeanKg),
+                 float(c.tdeeFactor), float(c.adjustPerKg), float(c.floorScale), float(c.floorOffset),
+                 float(c.weeklyPerKg), float(c.proteinPerKg), float(c.fatPerKcal),
+                 float(c.carbsPerKcal), float(c.carbsPerProteinG) };
+    }
+
+    constexpr array<BasicPlanCoefficients<float>, PLAN_TABLE_SIZE> makePlanTableF32() {
+        array<BasicPlanCoefficients<float>, PLAN_TABLE_SIZE> table = {};
+        for (size_t i = 0; i < PLAN_TABLE_SIZE; ++i) table[i] = toFloat(PLAN_TABLE[i]);
+        return table;
+    }
+
+    constexpr array<BasicPlanCoefficients<float>, PLAN_TABLE_SIZE> PLAN_TABLE_F32 = makePlanTableF32();
+
+    // --- fixed point ---
+    //
+    // With kg and cm in 1/128 units, every coefficient of the plan becomes a small
+    // integer once each quantity gets its own scale (planner.h):
+    //   bmr    * 512   = 40*kg + 25*cm - 2560*age + 512*c
+    //   tdee   * 20480 = (40 * activityFactor) * bmr           factors 48, 55, 62, 69, 76
+    //   adjust * 20480 = sign * 440 * (400 * paceFraction) * kg   7700/7 = 1100 kcal/kg/day
+    //   floor  * 20480 = 44 * bmr                                1.1 * 40
+    //   weekly * 51200 = (400 * paceFraction) * kg
+    //   protein * 640  = (5 * proteinPerKg) * kg                 11, 9, 8
+    //   fat    * 737280 = target                                 0.25 / 9 = 1/36
+    //   carbs  * 327680 = 3*target - 512*protein                 (0.75*target - 4*protein) / 4
+    // The largest intermediate, 3*target at 500 kg / 300 cm / Extra / Bulk, stays
+    // under 1.2e9, so nothing overflows int32 for inputs validateInput accepts.
+
+    const int32_t FX_BMR_KG  = 40;
+    const int32_t FX_BMR_CM  = 25;
+    const int32_t FX_BMR_AGE = -5 * FIXED_BMR_SCALE;
+    const int32_t FX_NO_FLOOR = -(1 << 30);
+
+    static_assert(FIXED_KCAL_SCALE == 40 * FIXED_BMR_SCALE, "tdee = (40 * activityFactor) * bmr");
+    static_assert(FIXED_FAT_SCALE == 36 * FIXED_KCAL_SCALE, "fat_g = target / 36");
+    static_assert(FIXED_CARBS_SCALE == 16 * FIXED_KCAL_SCALE, "carbs_g = 3/16 target - protein");
+    static_assert(FIXED_CARBS_SCALE == 512 * FIXED_PROTEIN_SCALE, "protein term scale in carbs");
+
+    template <class V>
+    struct FixedPlanCoefficients {
+        V bmrConst, tdeeFactor, adjustPerKg, floorScale, floorOffset, weeklyPerKg, proteinPerKg;
+    };
+
+    constexpr int32_t roundToInt(double x) { return int32_t(x < 0 ? x - 0.5 : x + 0.5); }
+
+    constexpr FixedPlanCoefficients<int32_t> makeFixedCoefficients(Sex sex, Activity activity, Goal goal, Pace pace) {
+        const bool    cut    = goal == Goal::Cut;
+        const int32_t sign   = cut ? -1 : (goal == Goal::Bulk ? 1 : 0);
+        const int32_t weekly = (goal == Goal::Maintain) ? 0 : roundToInt(paceFraction(pace) * 400.0);
+
+        FixedPlanCoefficients<int32_t> c = {};
+        c.bmrConst     = (sex == Sex::Male) ? 5 * FIXED_BMR_SCALE : -161 * FIXED_BMR_SCALE;
+        c.tdeeFactor   = roundToInt(activityFactor(activity) * 40.0);
+        c.adjustPerKg  = sign * weekly * 440;
+        c.floorScale   = cut ? roundToInt(MIN_CALORIE_MULTIPLIER * 40.0) : 0;
+        c.floorOffset  = cut ? 0 : FX_NO_FLOOR;
+        c.weeklyPerKg  = weekly;
+        c.proteinPerKg = roundToInt(proteinPerKg(goal) * 5.0);
+        return c;
+    }
+
+    constexpr array<FixedPlanCoefficients<int32_t>, PLAN_TABLE_SIZE> makeFixedTable() {
+        array<FixedPlanCoefficients<int32_t>, PLAN_TABLE_SIZE> table = {};
+        for (size_t s = 0; s < PLAN_SEXES; ++s)
+            for (size_t a = 0; a < PLAN_ACTIVITIES; ++a)
+                for (size_t g = 0; g < PLAN_GOALS; ++g)
+                    for (size_t p = 0; p < PLAN_PACES; ++p) {
+                        Sex sex = static_cast<Sex>(s);
+                        Activity activity = static_cast<Activity>(a + 1);
+                        Goal goal = static_cast<Goal>(g);
+                        Pace pace = static_cast<Pace>(p);
+                        table[planTableIndex(sex, activity, goal, pace)] =
+                            makeFixedCoefficients(sex, activity, goal, pace);
+                    }
+        return table;
+    }
+
+    constexpr array<FixedPlanCoefficients<int32_t>, PLAN_TABLE_SIZE> FIXED_PLAN_TABLE = makeFixedTable();
+
+    // The integer coefficients must reproduce the double ones exactly
+    constexpr bool fixedTableExact() {
+        for (size_t i = 0; i < PLAN_TABLE_SIZE; ++i) {
+            const PlanCoefficients& d = PLAN_TABLE[i];
+            const FixedPlanCoefficients<int32_t>& f = FIXED_PLAN_TABLE[i];
+            if (f.tdeeFactor * 40 != roundToInt(d.tdeeFactor * 1600.0)) return false;
+            if (f.adjustPerKg != roundToInt(d.adjustPerKg * 160.0)) return false;
+            if (f.weeklyPerKg != roundToInt(d.weeklyPerKg * 400.0)) return false;
+            if (f.proteinPerKg != roundToInt(d.proteinPerKg * 5.0)) return false;
+        }
+        return true;
+    }
+    static_assert(fixedTableExact(), "fixed-point table out of step with PLAN_TABLE");
+
+    typedef Simd<int32_t>::vec vint;
+    const size_t INT_LANES = Simd<int32_t>::LANES;
+    static_assert(BLOCK_ROWS % Simd<int32_t>::LANES == 0, "blocks hold whole vector groups");
+
+    struct FixedTerms {
+        vint bmr, tdee, targetCalories, weeklyChangeKg, protein_g, carbs_g;
+    };
+
+    inline void evalPlanFixed(const FixedPlanCoefficients<vint>& c, const vint& kg, const vint& cm, const vint& age,
+                              FixedTerms& t) {
+        const vint zero = {};
+        t.bmr  = FX_BMR_KG * kg + FX_BMR_CM * cm + FX_BMR_AGE * age + c.bmrConst;
+        t.tdee = c.tdeeFactor * t.bmr;
+
+        vint target    = c.adjustPerKg * kg + t.tdee;
+        vint floorKcal = c.floorScale * t.bmr + c.floorOffset;
+        t.targetCalories = (target < floorKcal) ? floorKcal : target;
+        t.weeklyChangeKg = c.weeklyPerKg * kg;
+
+        t.protein_g = c.proteinPerKg * kg;
+        vint carbs  = 3 * t.targetCalories - 512 * t.protein_g;
+        t.carbs_g   = (zero < carbs) ? carbs : zero;
+    }
+
+    int32_t toFixed(double x) { return int32_t(lround(x * FIXED_INPUT_SCALE)); }
+}
+
+PlanResult PlanBatchResultFixed::row(size_t i) const {
+    PlanResult r;
+    r.bmr            = double(bmr[i]) / FIXED_BMR_SCALE;
+    r.tdee           = double(tdee[i]) / FIXED_KCAL_SCALE;
+    r.targetCalories = double(targetCalories[i]) / FIXED_KCAL_SCALE;
+    r.weeklyChangeKg = double(weeklyChangeKg[i]) / FIXED_WEEKLY_KG_SCALE;
+    r.weeklyChangeLb = r.weeklyChangeKg * LB_PER_KG;
+    r.paceUsed       = paceUsed[i];
+    r.macros         = { r.targetCalories,
+                         double(protein_g[i]) / FIXED_PROTEIN_SCALE,
+                         double(targetCalories[i]) / FIXED_FAT_SCALE,
+                         double(carbs_g[i]) / FIXED_CARBS_SCALE };
+    return r;
+}
+
+void computePlanBatchF32(const PlanBatchInput& in, PlanBatchResultF32& out) {
+    planBatch(in, out, PLAN_TABLE_F32.data());
+}
+
+void computePlanBatchFixed(const PlanBatchInput& in, PlanBatchResultFixed& out) {
+    const size_t n = in.size();
+    prepareBatch(in, out);
+    out.bmr.resize(n);
+    out.tdee.resize(n);
+    out.targetCalories.resize(n);
+    out.weeklyChangeKg.resize(n);
+    out.protein_g.resize(n);
+    out.carbs_g.resize(n);
+
+    // Zeroed so tail lanes past n multiply zeros or an earlier block's in-range
+    // rows; uninitialized lanes could overflow the int32 arithmetic
+    struct Block {
+        FixedPlanCoefficients<Column<int32_t>> coef;
+        Column<int32_t> kg, cm, age;
+    } block{};
+    FixedPlanCoefficients<vint> c;
+    vint kg, cm, age;
+    FixedTerms t;
+
+    for (size_t start = 0; start < n; start += BLOCK_ROWS) {
+        size_t rows = min(BLOCK_ROWS, n - start);
+        for (size_t r = 0; r < rows; ++r) {
+            size_t i = start + r;
+            const auto& e = FIXED_PLAN_TABLE[planTableSlot(in.sex[i], in.activity[i], in.goal[i], in.pace[i])];
+            block.coef.bmrConst.v[r]     = e.bmrConst;
+            block.coef.tdeeFactor.v[r]   = e.tdeeFactor;
+            block.coef.adjustPerKg.v[r]  = e.adjustPerKg;
+            block.coef.floorScale.v[r]   = e.floorScale;
+            block.coef.floorOffset.v[r]  = e.floorOffset;
+            block.coef.weeklyPerKg.v[r]  = e.weeklyPerKg;
+            block.coef.proteinPerKg.v[r] = e.proteinPerKg;
+
+            // Out-of-range rows would overflow the quantization; they are zeroed below anyway
+            bool ok = out.status[i] == PLAN_OK;
+            block.kg.v[r]  = ok ? toFixed(in.weight[i]) : 0;
+            block.cm.v[r]  = ok ? toFixed(in.height[i]) : 0;
+            block.age.v[r] = ok ? in.ageYears[i] : 0;
+        }
+
+        for (size_t r = 0; r < rows; r += INT_LANES) {
+            size_t i = start + r, count = min(INT_LANES, rows - r);
+            loadLanes<int32_t>(c.bmrConst,     block.coef.bmrConst,     r);
+            loadLanes<int32_t>(c.tdeeFactor,   block.coef.tdeeFactor,   r);
+            loadLanes<int32_t>(c.adjustPerKg,  block.coef.adjustPerKg,  r);
+            loadLanes<int32_t>(c.floorScale,   block.coef.floorScale,   r);
+            loadLanes<int32_t>(c.floorOffset,  block.coef.floorOffset,  r);
+            loadLanes<int32_t>(c.weeklyPerKg,  block.coef.weeklyPerKg,  r);
+            loadLanes<int32_t>(c.proteinPerKg, block.coef.proteinPerKg, r);
+            loadLanes<int32_t>(kg, block.kg, r);
+            loadLanes<int32_t>(cm, block.cm, r);
+            loadLanes<int32_t>(age, block.age, r);
+
+            evalPlanFixed(c, kg, cm, age, t);
+            storeLanes<int32_t>(&out.bmr[i],            t.bmr, count);
+            storeLanes<int32_t>(&out.tdee[i],           t.tdee, count);
+            storeLanes<int32_t>(&out.targetCalories[i], t.targetCalories, count);
+            storeLanes<int32_t>(&out.weeklyChangeKg[i], t.weeklyChangeKg, count);
+            storeLanes<int32_t>(&out.protein_g[i],      t.protein_g, count);
+            storeLanes<int32_t>(&out.carbs_g[i],        t.carbs_g, count);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (out.status[i] == PLAN_OK) continue;
+        out.bmr[i] = out.tdee[i] = out.targetCalories[i] = 0;
+        out.weeklyChangeKg[i] = out.protein_g[i] = out.carbs_g[i] = 0;
+    }
+}
@@ -0,0 +1,147 @@
+// plan_simd.h
+// The block-transposed batch driver behind computePlanBatch and
+// the reduced-precision planners in plan_lowp.cpp.
+#pragma once
+#include "planner.h"
+#include "plan_kernel.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+
+// Rows per block; a block of gathered double columns (~17 KB) stays inside L1.
+const size_t BLOCK_ROWS = 128;
+
+template <class T>
+struct Column { T v[BLOCK_ROWS]; };
+
+template <class T>
+inline void loadLanes(typename Simd<T>::vec& v, const Column<T>& col, size_t r) {
+    memcpy(&v, &col.v[r], sizeof(v));
+}
+
+// Writes the first count lanes of v to dst (count < LANES only at the tail).
+template <class T>
+inline void storeLanes(T* dst, const typename Simd<T>::vec& v, size_t count) {
+    if (count == Simd<T>::LANES) memcpy(dst, &v, sizeof(v));
+    else                         memcpy(dst, &v, count * sizeof(T));
+}
+
+template <class T>
+void gatherRow(BasicPlanCoefficients<Column<T>>& cols, size_t r, const BasicPlanCoefficients<T>& c) {
+    cols.bmrKg.v[r]            = c.bmrKg;
+    cols.bmrCm.v[r]            = c.bmrCm;
+    cols.bmrAge.v[r]           = c.bmrAge;
+    cols.bmrConst.v[r]         = c.bmrConst;
+    cols.bmrLeanKg.v[r]        = c.bmrLeanKg;
+    cols.tdeeFactor.v[r]       = c.tdeeFactor;
+    cols.adjustPerKg.v[r]      = c.adjustPerKg;
+    cols.floorScale.v[r]       = c.floorScale;
+    cols.floorOffset.v[r]      = c.floorOffset;
+    cols.weeklyPerKg.v[r]      = c.weeklyPerKg;
+    cols.proteinPerKg.v[r]     = c.proteinPerKg;
+    cols.fatPerKcal.v[r]       = c.fatPerKcal;
+    cols.carbsPerKcal.v[r]     = c.carbsPerKcal;
+    cols.carbsPerProteinG.v[r] = c.carbsPerProteinG;
+}
+
+template <class T>
+void loadGroup(BasicPlanCoefficients<typename Simd<T>::vec>& v, const BasicPlanCoefficients<Column<T>>& cols, size_t r) {
+    loadLanes<T>(v.bmrKg,            cols.bmrKg,            r);
+    loadLanes<T>(v.bmrCm,            cols.bmrCm,            r);
+    loadLanes<T>(v.bmrAge,           cols.bmrAge,           r);
+    loadLanes<T>(v.bmrConst,         cols.bmrConst,         r);
+    loadLanes<T>(v.bmrLeanKg,        cols.bmrLeanKg,        r);
+    loadLanes<T>(v.tdeeFactor,       cols.tdeeFactor,       r);
+    loadLanes<T>(v.adjustPerKg,      cols.adjustPerKg,      r);
+    loadLanes<T>(v.floorScale,       cols.floorScale,       r);
+    loadLanes<T>(v.floorOffset,      cols.floorOffset,      r);
+    loadLanes<T>(v.weeklyPerKg,      cols.weeklyPerKg,      r);
+    loadLanes<T>(v.proteinPerKg,     cols.proteinPerKg,     r);
+    loadLanes<T>(v.fatPerKcal,       cols.fatPerKcal,       r);
+    loadLanes<T>(v.carbsPerKcal,     cols.carbsPerKcal,     r);
+    loadLanes<T>(v.carbsPerProteinG, cols.carbsPerProteinG, r);
+}
+
+// Sizes status and paceUsed to the input and fills them.
+template <class Result>
+void prepareBatch(const PlanBatchInput& in, Result& out) {
+    const size_t n = in.size();
+    out.status.resize(n);
+    out.paceUsed.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        out.status[i]   = planRangeStatus(in.weight[i], in.height[i], in.ageYears[i]);
+        out.paceUsed[i] = paceUsed(in.goal[i], in.pace[i]);
+    }
+}
+
+// computePlanBatch for element type T, with table indexed by planTableSlot.
+template <class T>
+void planBatch(const PlanBatchInput& in, BasicPlanBatchResult<T>& out, const BasicPlanCoefficients<T>* table) {
+    typedef typename Simd<T>::vec vec;
+    const size_t LANES = Simd<T>::LANES;
+    static_assert(BLOCK_ROWS % Simd<T>::LANES == 0, "blocks hold whole vector groups");
+
+    const size_t n = in.size();
+    prepareBatch(in, out);
+    out.bmr.resize(n);
+    out.tdee.resize(n);
+    out.targetCalories.resize(n);
+    out.weeklyChangeKg.resize(n);
+    out.weeklyChangeLb.resize(n);
+    out.calories.resize(n);
+    out.protein_g.resize(n);
+    out.fat_g.resize(n);
+    out.carbs_g.resize(n);
+
+    // One block of users transposed into plain columns. Filling these with scalar
+    // stores and loading whole vectors afterwards avoids inserting lanes into vector
+    // registers one at a time, which stalls on every insert. The block starts zeroed,
+    // so tail lanes past n compute on zeros or on an earlier block's rows and are
+    // never stored.
+    struct Block {
+        BasicPlanCoefficients<Column<T>> coef;
+        Column<T> kg, cm, age;
+    } block{};
+    BasicPlanCoefficients<vec> c;
+    vec kg, cm, age;
+    PlanTerms<vec> t;
+    const T lbPerKg = T(LB_PER_KG);
+
+    for (size_t start = 0; start < n; start += BLOCK_ROWS) {
+        size_t rows = std::min(BLOCK_ROWS, n - start);
+        for (size_t r = 0; r < rows; ++r) {
+            size_t i = start + r;
+            gatherRow(block.coef, r, table[planTableSlot(in.sex[i], in.activity[i], in.goal[i], in.pace[i])]);
+            block.kg.v[r]  = T(in.weight[i]);
+            block.cm.v[r]  = T(in.height[i]);
+            block.age.v[r] = T(in.ageYears[i]);
+        }
+
+        for (size_t r = 0; r < rows; r += LANES) {
+            size_t i = start + r, count = std::min(LANES, rows - r);
+            loadGroup<T>(c, block.coef, r);
+            loadLanes<T>(kg, block.kg, r);
+            loadLanes<T>(cm, block.cm, r);
+            loadLanes<T>(age, block.age, r);
+
+            evalPlan(c, kg, cm, age, t);
+            storeLanes<T>(&out.bmr[i],            t.bmr, count);
+            storeLanes<T>(&out.tdee[i],           t.tdee, count);
+            storeLanes<T>(&out.targetCalories[i], t.targetCalories, count);
+            storeLanes<T>(&out.weeklyChangeKg[i], t.weeklyChangeKg, count);
+            storeLanes<T>(&out.weeklyChangeLb[i], t.weeklyChangeKg * lbPerKg, count);
+            storeLanes<T>(&out.calories[i],       t.targetCalories, count);
+            storeLanes<T>(&out.protein_g[i],      t.protein_g, count);
+            storeLanes<T>(&out.fat_g[i],          t.fat_g, count);
+            storeLanes<T>(&out.carbs_g[i],        t.carbs_g, count);
+        }
+    }
+
+    // Invalid rows were planned anyway (branch-free); clear them now.
+    for (size_t i = 0; i < n; ++i) {
+        if (out.status[i] == PLAN_OK) continue;
+        out.bmr[i] = out.tdee[i] = out.targetCalories[i] = T(0);
+        out.weeklyChangeKg[i] = out.weeklyChangeLb[i] = T(0);
+        out.calories[i] = out.protein_g[i] = out.fat_g[i] = out.carbs_g[i] = T(0);
+    }
+}
@@ -0,0 +1,54 @@
+// plan_trajectory.cpp
+// Multi-week weight projection. Each week is stepped from the previous week's
+// weight and BMR using the linear plan coefficients, instead of re-running
+// computePlan from scratch for every week.
+#include "planner.h"
+#include "plan_kernel.h"
+#include <algorithm>
+
+using namespace std;
+
+PlanTrajectory simulateTrajectory(const UserInput& u, int weeks, double targetWeightKg) {
+    PlanTrajectory out;
+    out.status = checkInput(u);
+    if (!out.ok()) return out;
+
+    weeks = max(0, min(weeks, MAX_TRAJECTORY_WEEKS));
+    out.weeks.reserve(weeks + 1);
+
+    const PlanCoefficients& c = planCoefficients(u.sex, u.activity, u.goal, u.pace);
+    const double startKg = u.weight;
+    const bool   losing  = targetWeightKg > 0 && targetWeightKg < startKg;
+
+    double kg  = startKg;
+    int    age = u.ageYears;
+    double bmr = c.bmrKg * kg + c.bmrCm * u.height + c.bmrAge * u.ageYears + c.bmrConst;
+
+    for (int week = 0; week <= weeks; ++week) {
+        double tdee      = c.tdeeFactor * bmr;
+        double target    = c.adjustPerKg * kg + tdee;
+        double floorKcal = c.floorScale * bmr + c.floorOffset;
+        target = max(target, floorKcal);
+
+        // Energy balance: a week at (target - tdee) kcal/day moves this much body mass
+        double deltaKg = (target - tdee) * 7.0 / KCAL_PER_KG_FAT;
+        out.weeks.push_back({ week, kg, bmr, tdee, target, deltaKg });
+
+        if (out.weeksToTarget < 0 && targetWeightKg > 0) {
+            bool reached = losing ? kg <= targetWeightKg : kg >= targetWeightKg;
+            if (reached) out.weeksToTarget = week;
+        }
+
+        // BMR is linear in weight and age, so it moves by bmrKg per kg gained
+        // or lost and by bmrAge each time the user turns a year older, while
+        // the age stays in the range the planner accepts
+        kg  += deltaKg;
+        bmr += c.bmrKg * deltaKg;
+        if ((week + 1) % WEEKS_PER_YEAR == 0 && age < MAX_AGE_YEARS) {
+            ++age;
+            bmr += c.bmrAge;
+        }
+        if (kg <= 0 || kg > 500) break;
+    }
+    return out;
+}
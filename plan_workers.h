@@ -0,0 +1,42 @@
+// plan_workers.h
+// Threads the planners start per request, drawn from one process-wide budget.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Most threads one /plan/week or /plan/grid request runs on, its own included
+const unsigned MAX_REQUEST_THREADS = 4;
+
+// Helper threads every planner request together may have running: one per
+// core. A request borrows what is free without waiting and gives it back when
+// done, so concurrent requests share the cores instead of each starting a
+// thread per core and starving the HTTP workers.
+class PlanWorkerLease {
+public:
+    explicit PlanWorkerLease(unsigned wanted) {
+        unsigned free = available().load();
+        do {
+            granted = std::min(wanted, free);
+        } while (granted && !available().compare_exchange_weak(free, free - granted));
+    }
+    ~PlanWorkerLease() { available() += granted; }
+
+    PlanWorkerLease(const PlanWorkerLease&) = delete;
+    PlanWorkerLease& operator=(const PlanWorkerLease&) = delete;
+
+    unsigned count() const { return granted; }
+
+    // Threads a request asks for when the caller did not say
+    static unsigned defaultThreads() {
+        return std::max(1u, std::min(MAX_REQUEST_THREADS, std::thread::hardware_concurrency()));
+    }
+
+private:
+    unsigned granted = 0;
+
+    static std::atomic<unsigned>& available() {
+        static std::atomic<unsigned> free{ std::max(1u, std::thread::hardware_concurrency()) };
+        return free;
+    }
+};
@@ -1,6 +1,9 @@
 // planner.h
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 enum class Sex { Male, Female };
 enum class Units { Metric, Imperial };
@@ -17,8 +20,12 @@ struct UserInput {
     Activity activity;
     Goal goal;
     Pace pace;
+    double bodyFatPct = 0.0; // optional; only the lean-mass BMR formulas need it
 };
 
+const int MIN_AGE_YEARS = 15;    // validateInput's accepted age range
+const int MAX_AGE_YEARS = 120;
+
 struct MacroPlan {
     double calories;
     double protein_g;
@@ -36,5 +43,222 @@ struct PlanResult {
     MacroPlan macros;
 };
 
+// Per-row validation status for batch planning; one bit per out-of-range field.
+enum PlanStatus : unsigned char {
+    PLAN_OK           = 0,
+    PLAN_BAD_WEIGHT   = 1 << 0,
+    PLAN_BAD_HEIGHT   = 1 << 1,
+    PLAN_BAD_AGE      = 1 << 2,
+    PLAN_BAD_BODY_FAT = 1 << 3,  // only checked for lean-mass BMR formulas
+};
+
+// --- BMR formulas ---
+// Each estimator is linear in its inputs:
+//   bmr = perKg*kg + perCm*cm + perAge*age + perLeanKg*leanKg + constant
+// with leanKg = kg * (1 - bodyFatPct / 100). The planners take the formula as a
+// template parameter, so the choice folds into the coefficient table at compile time.
+struct BmrLinear {
+    double perKg, perCm, perAge, perLeanKg, constant;
+};
+
+struct MifflinStJeor {
+    static constexpr const char* NAME = "mifflin_st_jeor";
+    static constexpr bool USES_LEAN_MASS = false;
+    static constexpr BmrLinear terms(Sex sex) {
+        return { 10.0, 6.25, -5.0, 0.0, sex == Sex::Male ? 5.0 : -161.0 };
+    }
+};
+
+// Roza & Shizgal (1984) revision of Harris-Benedict
+struct HarrisBenedict {
+    static constexpr const char* NAME = "harris_benedict";
+    static constexpr bool USES_LEAN_MASS = false;
+    static constexpr BmrLinear terms(Sex sex) {
+        return sex == Sex::Male ? BmrLinear{ 13.397, 4.799, -5.677, 0.0, 88.362 }
+                                : BmrLinear{ 9.247, 3.098, -4.330, 0.0, 447.593 };
+    }
+};
+
+struct KatchMcArdle {
+    static constexpr const char* NAME = "katch_mcardle";
+    static constexpr bool USES_LEAN_MASS = true;
+    static constexpr BmrLinear terms(Sex) { return { 0.0, 0.0, 0.0, 21.6, 370.0 }; }
+};
+
+struct Cunningham {
+    static constexpr const char* NAME = "cunningham";
+    static constexpr bool USES_LEAN_MASS = true;
+    static constexpr BmrLinear terms(Sex) { return { 0.0, 0.0, 0.0, 22.0, 500.0 }; }
+};
+
+// Runtime name for the policies above, in this order.
+enum class BmrFormula { MifflinStJeor, HarrisBenedict, KatchMcArdle, Cunningham };
+const size_t BMR_FORMULA_COUNT = 4;
+
+// Structure-of-arrays input: one column per UserInput field, all the same length.
+struct PlanBatchInput {
+    std::vector<Sex>      sex;
+    std::vector<int>      ageYears;
+    std::vector<double>   height; // cm
+    std::vector<double>   weight; // kg
+    std::vector<Activity> activity;
+    std::vector<Goal>     goal;
+    std::vector<Pace>     pace;
+    std::vector<double>   bodyFatPct;
+
+    size_t size() const { return weight.size(); }
+    void push_back(const UserInput& u);
+    void clear();
+};
+
+// Structure-of-arrays output. Rows whose status is not PLAN_OK are zeroed.
+// T is double for computePlanBatch and float for computePlanBatchF32.
+template <class T>
+struct BasicPlanBatchResult {
+    std::vector<T>      bmr;
+    std::vector<T>      tdee;
+    std::vector<T>      targetCalories;
+    std::vector<T>      weeklyChangeKg;
+    std::vector<T>      weeklyChangeLb;
+    std::vector<Pace>   paceUsed;
+    std::vector<T>      calories;
+    std::vector<T>      protein_g;
+    std::vector<T>      fat_g;
+    std::vector<T>      carbs_g;
+    std::vector<unsigned char> status; // PlanStatus bits
+
+    size_t size() const { return status.size(); }
+
+    PlanResult row(size_t i) const {
+        PlanResult r;
+        r.bmr            = bmr[i];
+        r.tdee           = tdee[i];
+        r.targetCalories = targetCalories[i];
+        r.weeklyChangeKg = weeklyChangeKg[i];
+        r.weeklyChangeLb = weeklyChangeLb[i];
+        r.paceUsed       = paceUsed[i];
+        r.macros         = { double(calories[i]), double(protein_g[i]), double(fat_g[i]), double(carbs_g[i]) };
+        return r;
+    }
+};
+
+using PlanBatchResult    = BasicPlanBatchResult<double>;
+using PlanBatchResultF32 = BasicPlanBatchResult<float>;
+
+// Units of the computePlanBatchFixed columns: a stored value v means v / SCALE.
+// Weight and height are rounded to 1/FIXED_INPUT_SCALE on the way in; everything
+// after that is exact int32 arithmetic for any input validateInput accepts.
+const int32_t FIXED_INPUT_SCALE     = 128;     // kg, cm
+const int32_t FIXED_BMR_SCALE       = 512;     // bmr kcal
+const int32_t FIXED_KCAL_SCALE      = 20480;   // tdee, targetCalories kcal
+const int32_t FIXED_WEEKLY_KG_SCALE = 51200;   // weeklyChangeKg
+const int32_t FIXED_PROTEIN_SCALE   = 640;     // protein_g
+const int32_t FIXED_FAT_SCALE       = 737280;  // fat_g, read from targetCalories
+const int32_t FIXED_CARBS_SCALE     = 327680;  // carbs_g
+
+struct PlanBatchResultFixed {
+    std::vector<int32_t> bmr;
+    std::vector<int32_t> tdee;
+    std::vector<int32_t> targetCalories;  // fat_g is targetCalories / FIXED_FAT_SCALE
+    std::vector<int32_t> weeklyChangeKg;
+    std::vector<int32_t> protein_g;
+    std::vector<int32_t> carbs_g;
+    std::vector<Pace>    paceUsed;
+    std::vector<unsigned char> status;    // PlanStatus bits
+
+    size_t size() const { return status.size(); }
+    PlanResult row(size_t i) const;       // converted back to kcal, kg and g
+};
+
+// Per-field detail for a failed range check, listed in validateInput's order.
+struct PlanFieldError {
+    PlanStatus  field;   // single PLAN_BAD_* bit
+    const char* name;    // UserInput member
+    const char* message;
+};
+
+const size_t PLAN_FIELD_COUNT = 4;
+extern const PlanFieldError PLAN_FIELD_ERRORS[PLAN_FIELD_COUNT];
+
+// Result-or-error from tryComputePlan. result is zeroed unless ok().
+struct PlanOutcome {
+    unsigned char status = PLAN_OK; // PlanStatus bits, one per bad field
+    PlanResult    result = {};
+
+    bool ok() const { return status == PLAN_OK; }
+};
+
 // implemented in planner.cpp (your refactored code)
+// Throws std::invalid_argument on out-of-range input; thin wrapper over tryComputePlan.
 PlanResult computePlan(const UserInput& u);
+
+// Exception-free planning for request handlers and batch code.
+PlanOutcome tryComputePlan(const UserInput& u) noexcept;
+
+// Same plan with BMR from the given formula. Lean-mass formulas also range-check
+// bodyFatPct. Instantiated for the four formulas above.
+template <class Bmr>
+PlanOutcome tryComputePlanWith(const UserInput& u) noexcept;
+
+PlanOutcome tryComputePlan(const UserInput& u, BmrFormula formula) noexcept;
+
+// Non-throwing range check; returns PLAN_OK or the PlanStatus bits that failed.
+unsigned char checkInput(const UserInput& u) noexcept;
+
+// Message for the first failing field, matching validateInput's wording.
+const char* planStatusMessage(unsigned char status) noexcept;
+
+// Plans every row at once; invalid rows are flagged in out.status instead of throwing.
+void computePlanBatch(const PlanBatchInput& in, PlanBatchResult& out);
+
+// Every BMR formula side by side, one row per input. Columns are indexed by BmrFormula.
+// Rows a formula cannot plan (bad range, or missing body fat for the lean-mass
+// ones) are zeroed in that formula's columns and flagged in its status.
+struct BmrComparison {
+    std::vector<double>        bmr[BMR_FORMULA_COUNT];
+    std::vector<double>        tdee[BMR_FORMULA_COUNT];
+    std::vector<double>        targetCalories[BMR_FORMULA_COUNT];
+    std::vector<unsigned char> status[BMR_FORMULA_COUNT]; // PlanStatus bits
+
+    size_t size() const { return status[0].size(); }
+};
+
+// Evaluates all formulas in one pass over in (plan_bmr.cpp): inputs and the
+// activity/goal/pace factors are loaded once per row and shared by every formula.
+void compareBmrFormulas(const PlanBatchInput& in, BmrComparison& out);
+
+// Reduced-precision batch planners (plan_lowp.cpp) for bulk analytics, where
+// twice as many rows fit in each SIMD register. Same validation and zeroing as
+// computePlanBatch; bench/plan_accuracy measures how far they drift from it.
+void computePlanBatchF32(const PlanBatchInput& in, PlanBatchResultF32& out);
+void computePlanBatchFixed(const PlanBatchInput& in, PlanBatchResultFixed& out);
+
+// --- Weight trajectory (plan_trajectory.cpp) ---
+
+const int MAX_TRAJECTORY_WEEKS = 520;
+const int WEEKS_PER_YEAR       = 52;    // the trajectory ages the user a year at a time
+
+// State at the start of a week, following that week's plan.
+struct TrajectoryWeek {
+    int    week;            // 0 = today
+    double weightKg;
+    double bmr;
+    double tdee;
+    double targetCalories;
+    double weeklyChangeKg;  // signed; negative when losing
+};
+
+struct PlanTrajectory {
+    unsigned char status = PLAN_OK;   // PlanStatus bits for the starting input
+    std::vector<TrajectoryWeek> weeks;
+    int weeksToTarget = -1;           // first week at or past targetWeightKg, -1 if never
+
+    bool ok() const { return status == PLAN_OK; }
+};
+
+// Simulates up to `weeks` weeks of following the plan, re-targeting as weight moves
+// and ageing the user a year every WEEKS_PER_YEAR weeks, up to MAX_AGE_YEARS; past
+// that the BMR age term stays where validateInput's range ends.
+// Stops early if weight leaves validateInput's range. targetWeightKg <= 0 means none.
+PlanTrajectory simulateTrajectory(const UserInput& u, int weeks, double targetWeightKg = 0.0);
+
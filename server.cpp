@@ -1,42 +1,34 @@
 #include <iostream>
 #include <fstream>   // NEW: Needed to read html files
 #include <streambuf> // NEW: Needed to read html files
+#include <sstream>
+#include <thread>
 
 #include "httplib.h"
 #include "json.hpp"
 #include "planner.h"
 #include "food_api.h"
+#include "food_store.h"
+#include "food_disk_cache.h"
+#include "goal_foods.h"
+#include "api_json.h"
+#include "usda_client.h"
+#include "config.h"
 
 using json = nlohmann::json;
 using namespace std;
 using namespace httplib;
 
-// --- small helpers to map strings <-> enums ---
-
-Sex parseSex(const string& s) {
-    if (s == "male" || s == "Male" || s == "M") return Sex::Male;
-    return Sex::Female;
-}
-
-Activity parseActivity(const string& s) {
-    if (s == "sedentary")  return Activity::Sedentary;
-    if (s == "light")      return Activity::Light;
-    if (s == "moderate")   return Activity::Moderate;
-    if (s == "very")       return Activity::Very;
-    if (s == "extra")      return Activity::Extra;
-    return Activity::Moderate;
-}
-
-Goal parseGoal(const string& s) {
-    if (s == "cut")      return Goal::Cut;
-    if (s == "bulk")     return Goal::Bulk;
-    return Goal::Maintain;
+// Invalid UTF-8 from upstream data is replaced rather than thrown.
+void sendJson(Response& res, const json& body) {
+    res.set_content(body.dump(-1, ' ', false, json::error_handler_t::replace), "application/json");
 }
 
-Pace parsePace(const string& s) {
-    if (s == "slow")       return Pace::Slow;
-    if (s == "aggressive") return Pace::Aggressive;
-    return Pace::Normal;
+void sendBadRequest(Response& res, const string& message) {
+    res.status = 400;
+    json err;
+    err["error"] = "Bad request: " + message;
+    sendJson(res, err);
 }
 
 // --- CORS helper ---
@@ -48,6 +40,9 @@ void add_cors_headers(Response& res) {
 
 int main() {
     Server svr;
+    // Responses go out as a header write and a body write; without this, Nagle
+    // holds the body for the client's delayed ACK (~40 ms per keep-alive request)
+    svr.set_tcp_nodelay(true);
 
     // --- 1. SERVE STATIC FILES (HTML/CSS) ---
     
@@ -85,77 +80,269 @@ int main() {
 
     svr.Post("/plan", [](const Request& req, Response& res) {
         add_cors_headers(res);
-        try {
-            auto body = json::parse(req.body);
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded()) return sendBadRequest(res, "malformed JSON");
+
+        UserInput u;
+        string error;
+        if (!parseUserInput(body, u, error)) return sendBadRequest(res, error);
+
+        // Optional "bmr_formula"; katch_mcardle and cunningham also need "body_fat_pct"
+        BmrFormula formula = BmrFormula::MifflinStJeor;
+        string formulaName;
+        if (body.contains("bmr_formula") &&
+            (!readString(body, "bmr_formula", formulaName) || !parseBmrFormula(formulaName, formula)))
+            return sendBadRequest(res, "unknown bmr_formula");
+
+        PlanOutcome plan = tryComputePlan(u, formula);
+        if (!plan.ok()) {
+            res.status = 400;
+            return sendJson(res, planErrorToJson(plan.status));
+        }
+
+        sendJson(res, planToJson(plan.result));
+    });
+
+    // Plans for many clients in one request: {"users": [ <same fields as /plan>, ... ]}.
+    // Out-of-range rows come back with "status": "error" instead of failing the batch.
+    svr.Post("/plan/batch", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded()) return sendBadRequest(res, "malformed JSON");
+
+        auto users = body.is_object() ? body.find("users") : body.end();
+        if (users == body.end() || !users->is_array()) return sendBadRequest(res, "users must be an array");
+
+        PlanBatchInput in;
+        string error;
+        for (size_t i = 0; i < users->size(); ++i) {
             UserInput u;
-            u.units    = Units::Metric; 
-            u.sex      = parseSex(body.at("sex").get<string>());
-            u.ageYears = body.at("age").get<int>();
-            u.height   = body.at("height_cm").get<double>();
-            u.weight   = body.at("weight_kg").get<double>();
-            u.activity = parseActivity(body.at("activity").get<string>());
-            u.goal     = parseGoal(body.at("goal").get<string>());
-            u.pace     = parsePace(body.at("pace").get<string>());
-
-            PlanResult r = computePlan(u);
-
-            json out;
-            out["bmr"]            = r.bmr;
-            out["tdee"]           = r.tdee;
-            out["targetCalories"] = r.targetCalories;
-            out["weeklyChangeKg"] = r.weeklyChangeKg;
-            out["weeklyChangeLb"] = r.weeklyChangeLb;
-
-            out["macros"] = {
-                {"calories",  r.macros.calories},
-                {"protein_g", r.macros.protein_g},
-                {"fat_g",     r.macros.fat_g},
-                {"carbs_g",   r.macros.carbs_g}
-            };
-
-            res.set_content(out.dump(), "application/json");
-        } catch (const std::exception& e) {
+            if (!parseUserInput((*users)[i], u, error))
+                return sendBadRequest(res, "users[" + to_string(i) + "]: " + error);
+            in.push_back(u);
+        }
+
+        PlanBatchResult r;
+        computePlanBatch(in, r);
+
+        json out;
+        out["count"]   = r.size();
+        out["results"] = json::array();
+        for (size_t i = 0; i < r.size(); ++i) {
+            json row;
+            if (r.status[i] == PLAN_OK) {
+                row = planToJson(r.row(i));
+                row["status"] = "ok";
+            } else {
+                row = planErrorToJson(r.status[i]);
+                row["error"]  = planStatusMessage(r.status[i]);
+                row["status"] = "error";
+            }
+            out["results"].push_back(row);
+        }
+
+        sendJson(res, out);
+    });
+
+    // BMR, TDEE and target calories under every BMR formula, side by side.
+    // Takes a single /plan body, or {"users": [...]} for many at once.
+    svr.Post("/plan/bmr-compare", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded()) return sendBadRequest(res, "malformed JSON");
+
+        PlanBatchInput in;
+        string error;
+        auto users = body.is_object() ? body.find("users") : body.end();
+        if (users == body.end()) {
+            UserInput u;
+            if (!parseUserInput(body, u, error)) return sendBadRequest(res, error);
+            in.push_back(u);
+        } else {
+            if (!users->is_array()) return sendBadRequest(res, "users must be an array");
+            for (size_t i = 0; i < users->size(); ++i) {
+                UserInput u;
+                if (!parseUserInput((*users)[i], u, error))
+                    return sendBadRequest(res, "users[" + to_string(i) + "]: " + error);
+                in.push_back(u);
+            }
+        }
+
+        BmrComparison cmp;
+        compareBmrFormulas(in, cmp);
+
+        if (users == body.end()) return sendJson(res, bmrComparisonToJson(cmp, 0));
+        json out;
+        out["count"]   = cmp.size();
+        out["results"] = json::array();
+        for (size_t i = 0; i < cmp.size(); ++i) out["results"].push_back(bmrComparisonToJson(cmp, i));
+        sendJson(res, out);
+    });
+
+    // Week-by-week projection: /plan fields plus "weeks" (default 52, max 520)
+    // and an optional "target_weight_kg" to report when it is reached.
+    svr.Post("/plan/trajectory", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded()) return sendBadRequest(res, "malformed JSON");
+
+        UserInput u;
+        string error;
+        if (!parseUserInput(body, u, error)) return sendBadRequest(res, error);
+
+        int weeks = 52;
+        double targetWeight = 0.0;
+        if (body.contains("weeks") && !readInt(body, "weeks", weeks))
+            return sendBadRequest(res, "missing or invalid field 'weeks'");
+        if (weeks < 1 || weeks > MAX_TRAJECTORY_WEEKS)
+            return sendBadRequest(res, "weeks must be between 1 and " + to_string(MAX_TRAJECTORY_WEEKS));
+        if (body.contains("target_weight_kg") && !readNumber(body, "target_weight_kg", targetWeight))
+            return sendBadRequest(res, "missing or invalid field 'target_weight_kg'");
+
+        PlanTrajectory trajectory = simulateTrajectory(u, weeks, targetWeight);
+        if (!trajectory.ok()) {
             res.status = 400;
-            json err;
-            err["error"] = string("Bad request: ") + e.what();
-            res.set_content(err.dump(), "application/json");
+            return sendJson(res, planErrorToJson(trajectory.status));
         }
+
+        sendJson(res, trajectoryToJson(trajectory));
     });
 
-    svr.Post("/api/recommend-foods", [](const Request& req, Response& res) {
+    // Every combination of the given ranges, streamed as NDJSON (one plan per line):
+    // {"age": {"from":15,"to":120,"step":1}, "height_cm": 175, "weight_kg": {...},
+    //  "sex": [...], "activity": [...], "goal": [...], "pace": [...]}
+    svr.Post("/plan/grid", [](const Request& req, Response& res) {
         add_cors_headers(res);
-        try {
-            auto body = json::parse(req.body);
-            string goal = body.at("goal").get<string>();
-            double targetProtein = body.at("targetProtein").get<double>();
-            double targetCalories = body.at("targetCalories").get<double>();
-            
-            FoodRecommendations recommendations = recommendFoods(goal, targetProtein, targetCalories);
-            
-            json out;
-            out["goal"] = recommendations.goal_type;
-            out["foods"] = json::array();
-            
-            for (const auto& food : recommendations.foods) {
-                json foodJson;
-                foodJson["id"] = food.fdcId;
-                foodJson["name"] = food.description;
-                foodJson["calories"] = food.calories;
-                foodJson["protein_g"] = food.protein_g;
-                foodJson["carbs_g"] = food.carbs_g;
-                foodJson["fat_g"] = food.fat_g;
-                out["foods"].push_back(foodJson);
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded()) return sendBadRequest(res, "malformed JSON");
+
+        PlanGrid grid;
+        string error;
+        if (!parsePlanGrid(body, grid, error)) return sendBadRequest(res, error);
+
+        auto sweep = make_shared<PlanGridSweep>(move(grid), appendPlanNdjson);
+        res.set_chunked_content_provider("application/x-ndjson", [sweep](size_t, DataSink& sink) {
+            string chunk;
+            if (!sweep->next(chunk)) {
+                sink.done();
+                return true;
             }
-            
-            res.set_content(out.dump(), "application/json");
-        } catch (const exception& e) {
+            return sink.write(chunk.data(), chunk.size());
+        });
+    });
+
+    // Seven days of meals hitting the /plan macros: /plan fields plus optional
+    // "days", "meals", "foods_per_meal", "max_repeats" and "time_budget_ms"
+    svr.Post("/plan/week", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded()) return sendBadRequest(res, "malformed JSON");
+
+        UserInput u;
+        WeeklyPlanOptions opt;
+        string error;
+        if (!parseUserInput(body, u, error)) return sendBadRequest(res, error);
+        if (!parseWeeklyPlanOptions(body, opt, error)) return sendBadRequest(res, error);
+
+        PlanOutcome plan = tryComputePlan(u);
+        if (!plan.ok()) {
             res.status = 400;
-            json err;
-            err["error"] = string("Bad request: ") + e.what();
-            res.set_content(err.dump(), "application/json");
+            return sendJson(res, planErrorToJson(plan.status));
+        }
+
+        shared_ptr<const GoalFoods> pool = goalFoods(goalName(u.goal));
+        WeeklyPlan week = generateWeeklyPlan(pool->foods, plan.result.macros, opt);
+        json out = weeklyPlanToJson(week, pool->foods, opt);
+        out["plan"] = planToJson(plan.result);
+        sendJson(res, out);
+    });
+
+    svr.Post("/api/recommend-foods", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        json body = json::parse(req.body, nullptr, false);
+        if (body.is_discarded()) return sendBadRequest(res, "malformed JSON");
+
+        string goal;
+        double targetProtein, targetCalories;
+        if (!body.is_object() || !readString(body, "goal", goal))
+            return sendBadRequest(res, "missing or invalid field 'goal'");
+        if (!readNumber(body, "targetProtein", targetProtein))
+            return sendBadRequest(res, "missing or invalid field 'targetProtein'");
+        if (!readNumber(body, "targetCalories", targetCalories))
+            return sendBadRequest(res, "missing or invalid field 'targetCalories'");
+
+        FoodRecommendations recommendations = recommendFoods(goal, targetProtein, targetCalories);
+        sendJson(res, recommendationsToJson(recommendations));
+    });
+
+    // Autocomplete for a food search box: ?q=<typed prefix>&limit=<1..10>.
+    // Answered from memory, so it needs the offline store; without one the list is empty.
+    svr.Get("/api/foods/suggest", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        string q = req.get_param_value("q");
+        long limit = long(SUGGEST_TOP_K);
+        if (req.has_param("limit")) {
+            string s = req.get_param_value("limit");
+            char* end = nullptr;
+            limit = strtol(s.c_str(), &end, 10);
+            if (s.empty() || *end != '\0' || limit < 1 || limit > long(SUGGEST_TOP_K))
+                return sendBadRequest(res, "'limit' must be an integer from 1 to " + to_string(SUGGEST_TOP_K));
         }
+
+        const FoodStore* store = localFoodStore();
+        vector<FoodSuggester::Suggestion> suggestions;
+        if (store && store->suggester()) suggestions = store->suggester()->suggest(q, size_t(limit));
+        sendJson(res, suggestionsToJson(q, store, suggestions));
     });
 
+    // Counters of the USDA search cache (hits, misses, coalesced waits, evictions, ...)
+    svr.Get("/api/cache/stats", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        sendJson(res, foodCacheStatsToJson(foodSearchCache().stats()));
+    });
+
+    // Upstream health: breaker state, failures, hedges and the latency they are timed from
+    svr.Get("/api/upstream/stats", [](const Request& req, Response& res) {
+        add_cors_headers(res);
+        sendJson(res, usdaClientStatsToJson(usdaClientStats()));
+    });
+
+    // USDA timeouts, overridable for slow links, and the API keys to ration:
+    // USDA_API_KEYS (comma-separated) or else the one in config.h
+    UsdaClientOptions usda;
+    if (const char* ms = getenv("USDA_CONNECT_TIMEOUT_MS")) usda.connectTimeoutMs = max(1, atoi(ms));
+    if (const char* ms = getenv("USDA_TIMEOUT_MS")) usda.timeoutMs = max(1, atoi(ms));
+    if (const char* quota = getenv("USDA_HOURLY_QUOTA")) usda.hourlyQuota = max(1, atoi(quota));
+    if (const char* keys = getenv("USDA_API_KEYS")) {
+        stringstream list(keys);
+        for (string key; getline(list, key, ',');) {
+            if (!key.empty()) usda.apiKeys.push_back(key);
+        }
+    }
+    if (usda.apiKeys.empty()) usda.apiKeys.push_back(USDA_API_KEY);
+    configureUsdaClient(usda);
+
+    // Serve food searches from a local FoodData Central store when there is one
+    // (built by tools/fdc_ingest); otherwise warm the USDA connections
+    const char* storePath = getenv("FDC_STORE");
+    string storeError;
+    if (openLocalFoodStore(storePath ? storePath : "fdc_store.bin", storeError)) {
+        cout << "Serving " << localFoodStore()->size() << " foods offline from "
+             << localFoodStore()->path() << "\n";
+    } else {
+        if (storePath) cerr << "FDC_STORE: " << storeError << "\n";
+        // Keep USDA answers on disk so a restart does not start cold
+        const char* cachePath = getenv("FDC_CACHE");
+        string cacheError;
+        if (!openFoodDiskCache(cachePath ? cachePath : "usda_cache.bin", cacheError)) {
+            cerr << "FDC_CACHE: " << cacheError << "\n";
+        }
+        // Warm USDA connections in the background so the first searches reuse them
+        thread([] { prewarmFoodApi(); }).detach();
+    }
+    // Goal candidate pools for /api/recommend-foods and /plan/week, kept fresh in the background
+    startGoalFoodsRefresh();
+
     cout << "Listening on http://0.0.0.0:8080\n";
     svr.listen("0.0.0.0", 8080);
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+// simd.h
+// Fixed-width vector types shared by the planner kernels and the food search code.
+#pragma once
+#include <cstddef>
+
+#if defined(__GNUC__)
+// Generic vectors sized to the widest registers the target flags allow.
+// Wider-than-native vectors get split, and their compares/selects scalarized.
+  #if defined(__AVX512F__)
+const size_t SIMD_BYTES = 64;
+  #elif defined(__AVX__)
+const size_t SIMD_BYTES = 32;
+  #else
+const size_t SIMD_BYTES = 16;  // SSE2 / NEON
+  #endif
+
+template <class T>
+struct Simd {
+    static constexpr size_t LANES = SIMD_BYTES / sizeof(T);
+    typedef T vec __attribute__((vector_size(SIMD_BYTES)));
+};
+#else
+template <class T>
+struct Simd {
+    static constexpr size_t LANES = 1;
+    typedef T vec;
+};
+#endif
@@ -17,7 +17,7 @@ REM Use current dir for temp files so g++ does not use missing S:\ from a previo
 set TMP=%CD%
 set TEMP=%CD%
 
-"C:\msys64\mingw64\bin\g++.exe" -o server.exe server.cpp healthtracker.cpp -std=c++17 -pthread -D_WIN32_WINNT=0x0A00 -lws2_32
+"C:\msys64\mingw64\bin\g++.exe" -O2 -o server.exe server.cpp healthtracker.cpp api_json.cpp food_api.cpp usda_parse.cpp usda_quota.cpp usda_client.cpp food_table.cpp goal_foods.cpp food_cache.cpp food_disk_cache.cpp food_suggest.cpp food_fuzzy.cpp food_index.cpp food_store.cpp http_pool.cpp meal_plan.cpp meal_solver.cpp plan_bmr.cpp plan_lowp.cpp plan_grid.cpp plan_trajectory.cpp -std=c++17 -pthread -D_WIN32_WINNT=0x0A00 -lcurl -lws2_32
 echo.
 echo Exit code: %ERRORLEVEL%
 if %ERRORLEVEL% NEQ 0 (
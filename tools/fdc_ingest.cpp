@@ -0,0 +1,297 @@
+// fdc_ingest.cpp
+// Converts a FoodData Central bulk download into the memory-mapped store that
+// searchFoods serves from offline (see food_store.h).
+//
+//   ./fdc_ingest [--threads=n] <out.bin> <input>...
+//
+// Each input is either a directory from the CSV download (food.csv plus
+// food_nutrient.csv) or a JSON file: a bulk download (FoundationFoods,
+// SRLegacyFoods, BrandedFoods, SurveyFoods, ...) or a saved /foods/search
+// response. Inputs are mapped and split into newline-aligned chunks (CSV) or
+// the byte ranges of the individual foods (JSON), which are then parsed on
+// every core; a JSON file is never loaded into one DOM. A food listed twice
+// keeps its first appearance. The search index is written alongside as
+// <out.bin>.idx.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "food_store.h"
+#include "json.hpp"
+
+using json = nlohmann::json;
+using namespace std;
+
+namespace {
+
+// Work split into `parts` ranges, run on one thread each
+template <class Fn>
+void parallelFor(size_t parts, Fn fn) {
+    vector<thread> workers;
+    for (size_t t = 1; t < parts; ++t) workers.emplace_back(fn, t);
+    fn(size_t(0));
+    for (auto& w : workers) w.join();
+}
+
+// --- CSV ---
+
+// Splits one CSV record (no embedded newlines) into fields, unquoting "" escapes
+void splitCsv(const char* p, const char* end, vector<string>& fields) {
+    fields.clear();
+    while (true) {
+        string field;
+        if (p < end && *p == '"') {
+            for (++p; p < end; ++p) {
+                if (*p == '"') {
+                    if (p + 1 < end && p[1] == '"') { field += '"'; ++p; }
+                    else { ++p; break; }
+                } else {
+                    field += *p;
+                }
+            }
+        }
+        while (p < end && *p != ',') field += *p++;
+        fields.push_back(move(field));
+        if (p >= end) return;
+        ++p;
+    }
+}
+
+const char* lineEnd(const char* p, const char* end) {
+    const char* nl = static_cast<const char*>(memchr(p, '\n', size_t(end - p)));
+    return nl ? nl : end;
+}
+
+// Record [p, e) without its trailing \r
+const char* trimCr(const char* p, const char* e) { return (e > p && e[-1] == '\r') ? e - 1 : e; }
+
+int columnIndex(const vector<string>& header, const char* name) {
+    for (size_t i = 0; i < header.size(); ++i) if (header[i] == name) return int(i);
+    return -1;
+}
+
+bool ingestCsvDirectory(const string& dir, size_t threads, vector<FoodItem>& out, string& error) {
+    MappedFile foodFile, nutrientFile;
+    if (!foodFile.open(dir + "/food.csv", error) || !nutrientFile.open(dir + "/food_nutrient.csv", error))
+        return false;
+
+    // food.csv: one thread; descriptions may hold quoted commas
+    vector<string> fields;
+    const char* p = foodFile.data();
+    const char* end = p + foodFile.size();
+    const char* e = lineEnd(p, end);
+    splitCsv(p, trimCr(p, e), fields);
+    int idCol = columnIndex(fields, "fdc_id"), descCol = columnIndex(fields, "description");
+    if (idCol < 0 || descCol < 0) {
+        error = dir + "/food.csv lacks fdc_id or description";
+        return false;
+    }
+    const size_t first = out.size();
+    unordered_map<int, size_t> index;
+    for (p = e + 1; p < end; p = e + 1) {
+        e = lineEnd(p, end);
+        splitCsv(p, trimCr(p, e), fields);
+        if (int(fields.size()) <= max(idCol, descCol)) continue;
+        FoodItem f = { atoi(fields[idCol].c_str()), fields[descCol], 0, 0, 0, 0, {} };
+        if (f.fdcId <= 0 || !index.emplace(f.fdcId, out.size()).second) continue;
+        out.push_back(move(f));
+    }
+
+    // food_nutrient.csv: by far the biggest file, parsed in newline-aligned chunks
+    p   = nutrientFile.data();
+    end = p + nutrientFile.size();
+    e   = lineEnd(p, end);
+    splitCsv(p, trimCr(p, e), fields);
+    int fdcCol = columnIndex(fields, "fdc_id"), nutCol = columnIndex(fields, "nutrient_id"),
+        amountCol = columnIndex(fields, "amount");
+    if (fdcCol < 0 || nutCol < 0 || amountCol < 0) {
+        error = dir + "/food_nutrient.csv lacks fdc_id, nutrient_id or amount";
+        return false;
+    }
+    const char* body = min(e + 1, end);
+    const size_t bytes = size_t(end - body);
+
+    struct Row { int fdcId, nutrientId; double amount; };
+    vector<vector<Row>> rows(threads);
+    parallelFor(threads, [&](size_t t) {
+        const char* from = body + bytes * t / threads;
+        const char* to   = body + bytes * (t + 1) / threads;
+        if (t > 0) from = min(lineEnd(from - 1, end) + 1, end);   // start after the previous newline
+        vector<string> f;
+        for (const char* q = from; q < to && q < end;) {
+            const char* qe = lineEnd(q, end);
+            splitCsv(q, trimCr(q, qe), f);
+            if (int(f.size()) > max(fdcCol, max(nutCol, amountCol))) {
+                int id = atoi(f[nutCol].c_str());
+                if (nutrientById(id)) rows[t].push_back({ atoi(f[fdcCol].c_str()), id, atof(f[amountCol].c_str()) });
+            }
+            q = qe + 1;
+        }
+    });
+
+    vector<NutrientCollector> collected(out.size() - first);
+    for (const auto& chunk : rows) {
+        for (const Row& r : chunk) {
+            auto it = index.find(r.fdcId);
+            if (it != index.end()) collected[it->second - first].offer(nutrientById(r.nutrientId), r.amount);
+        }
+    }
+    for (size_t i = 0; i < collected.size(); ++i) out[first + i].setNutrients(collected[i].amount);
+    return true;
+}
+
+// --- JSON ---
+
+// Numeric field or 0; bulk files have nulls where a value is unknown
+double number(const json& obj, const char* key) {
+    auto it = obj.find(key);
+    return (it != obj.end() && it->is_number()) ? it->get<double>() : 0.0;
+}
+
+FoodItem jsonFood(const json& food) {
+    FoodItem f = { 0, "", 0, 0, 0, 0, {} };
+    auto id = food.find("fdcId");
+    if (id != food.end() && id->is_number_integer()) f.fdcId = id->get<int>();
+    auto desc = food.find("description");
+    if (desc != food.end() && desc->is_string()) f.description = desc->get<string>();
+
+    NutrientCollector c;
+    auto nutrients = food.find("foodNutrients");
+    if (nutrients != food.end() && nutrients->is_array()) {
+        for (const auto& n : *nutrients) {
+            if (!n.is_object()) continue;
+            // Bulk downloads: {"nutrient": {"id"}, "amount"}; search responses: {"nutrientId", "value"}
+            auto nested = n.find("nutrient");
+            if (nested != n.end() && nested->is_object())
+                c.offer(nutrientById(int(number(*nested, "id"))), number(n, "amount"));
+            else
+                c.offer(nutrientById(int(number(n, "nutrientId"))), number(n, "value"));
+        }
+    }
+    f.setNutrients(c.amount);
+    return f;
+}
+
+struct ByteRange { size_t begin, end; };
+
+// Finds the objects in the document's food arrays: the top-level array itself,
+// or every array-valued member of a top-level object. One sequential pass that
+// only tracks strings and bracket nesting; the objects are parsed separately.
+bool foodRanges(const char* data, size_t size, vector<ByteRange>& ranges) {
+    vector<char> open;           // brackets enclosing the current byte
+    auto inFoodArray = [&] {
+        return (open.size() == 1 && open[0] == '[') || (open.size() == 2 && open[0] == '{' && open[1] == '[');
+    };
+    size_t start = 0;
+    bool container = false;
+    for (size_t i = 0; i < size; ++i) {
+        char ch = data[i];
+        if (ch == '"') {
+            for (++i; i < size && data[i] != '"'; ++i) if (data[i] == '\\') ++i;
+            if (i >= size) return false;
+        } else if (ch == '{' || ch == '[') {
+            if (ch == '{' && inFoodArray()) start = i;
+            open.push_back(ch);
+            container = true;
+        } else if (ch == '}' || ch == ']') {
+            if (open.empty() || open.back() != (ch == '}' ? '{' : '[')) return false;
+            open.pop_back();
+            if (ch == '}' && inFoodArray()) ranges.push_back({ start, i + 1 });
+        }
+    }
+    return container && open.empty();
+}
+
+bool ingestJsonFile(const string& path, size_t threads, vector<FoodItem>& out, string& error) {
+    MappedFile file;
+    if (!file.open(path, error)) return false;
+    vector<ByteRange> ranges;
+    if (!foodRanges(file.data(), file.size(), ranges)) {
+        error = path + " is not valid JSON";
+        return false;
+    }
+
+    // Each thread parses its share of the foods one at a time
+    const size_t n = ranges.size();
+    vector<vector<FoodItem>> parts(threads);
+    vector<size_t> bad(threads, SIZE_MAX);
+    parallelFor(threads, [&](size_t t) {
+        for (size_t i = n * t / threads; i < n * (t + 1) / threads; ++i) {
+            const char* p = file.data();
+            json food = json::parse(p + ranges[i].begin, p + ranges[i].end, nullptr, false);
+            if (food.is_discarded()) {
+                bad[t] = ranges[i].begin;
+                return;
+            }
+            FoodItem f = jsonFood(food);
+            if (f.fdcId > 0) parts[t].push_back(move(f));
+        }
+    });
+    for (size_t offset : bad) {
+        if (offset == SIZE_MAX) continue;
+        error = path + ": the food at byte " + to_string(offset) + " is not valid JSON";
+        return false;
+    }
+    for (auto& part : parts) out.insert(out.end(), make_move_iterator(part.begin()), make_move_iterator(part.end()));
+    return true;
+}
+
+bool isJson(const string& path) {
+    return path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t threads = max(1u, thread::hardware_concurrency());
+    vector<string> args;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0) threads = max(1, atoi(arg.c_str() + 10));
+        else args.push_back(arg);
+    }
+    if (args.size() < 2) {
+        cerr << "usage: " << argv[0] << " [--threads=n] <out.bin> <csv-dir | file.json>..." << endl;
+        return 2;
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<FoodItem> foods;
+    string error;
+    for (size_t i = 1; i < args.size(); ++i) {
+        size_t before = foods.size();
+        bool ok = isJson(args[i]) ? ingestJsonFile(args[i], threads, foods, error)
+                                  : ingestCsvDirectory(args[i], threads, foods, error);
+        if (!ok) {
+            cerr << error << endl;
+            return 1;
+        }
+        cout << args[i] << ": " << foods.size() - before << " foods" << endl;
+    }
+
+    size_t total = foods.size();
+    if (!writeFoodStore(args[0], move(foods), error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    // Build the search index now so the server's first start does not have to
+    FoodStore store;
+    if (!store.open(args[0], error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    store.loadOrBuildIndex(args[0] + ".idx");
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("wrote %s (%zu foods from %zu records, %zu index terms) in %.2f s (%zu threads)\n", args[0].c_str(),
+           store.size(), total, store.index()->terms(), secs, threads);
+    return 0;
+}
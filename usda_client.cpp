@@ -0,0 +1,176 @@
+// usda_client.cpp
+#include "usda_client.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+CircuitBreaker::CircuitBreaker(int failureThreshold, chrono::milliseconds openFor)
+    : threshold(failureThreshold), cooldown(openFor) {}
+
+bool CircuitBreaker::allow() {
+    lock_guard<mutex> guard(lock);
+    switch (current) {
+    case CLOSED:
+        return true;
+    case OPEN:
+        if (chrono::steady_clock::now() < openedAt + cooldown) return false;
+        current = HALF_OPEN;
+        probing = true;
+        return true;
+    case HALF_OPEN:
+        if (probing) return false;
+        probing = true;
+        return true;
+    }
+    return false;
+}
+
+void CircuitBreaker::record(bool success) {
+    lock_guard<mutex> guard(lock);
+    if (success) {
+        current = CLOSED;
+        failures = 0;
+        probing = false;
+        return;
+    }
+    if (current == HALF_OPEN || ++failures >= threshold) {
+        current = OPEN;
+        openedAt = chrono::steady_clock::now();
+        failures = 0;
+        probing = false;
+    }
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+    lock_guard<mutex> guard(lock);
+    return current;
+}
+
+void CircuitBreaker::configure(int failureThreshold, chrono::milliseconds openFor) {
+    lock_guard<mutex> guard(lock);
+    threshold = max(1, failureThreshold);
+    cooldown = openFor;
+}
+
+void LatencyWindow::add(long ms) {
+    lock_guard<mutex> guard(lock);
+    samples[next] = ms;
+    next = (next + 1) % CAPACITY;
+    filled = min(filled + 1, CAPACITY);
+}
+
+size_t LatencyWindow::count() const {
+    lock_guard<mutex> guard(lock);
+    return filled;
+}
+
+long LatencyWindow::percentile(double p) const {
+    long copy[CAPACITY];
+    size_t n;
+    {
+        lock_guard<mutex> guard(lock);
+        n = filled;
+        copy_n(samples, n, copy);
+    }
+    if (n == 0) return 0;
+    size_t k = min(n - 1, size_t(p * double(n)));
+    nth_element(copy, copy + k, copy + n);
+    return copy[k];
+}
+
+namespace {
+    UsdaClientOptions options;
+    CircuitBreaker breaker(options.breakerFailures, chrono::milliseconds(options.breakerOpenMs));
+    LatencyWindow latencies;
+    QuotaScheduler quota;
+    atomic<uint64_t> requests{0}, failures{0}, shortCircuited{0}, hedges{0}, hedgeWins{0};
+
+    // p95 of recent successes, or 0 (no hedging) until there are enough of them
+    long hedgeDelay() {
+        if (latencies.count() < options.hedgeMinSamples) return 0;
+        return max(long(options.hedgeMinMs), latencies.percentile(0.95));
+    }
+
+    void recordOutcome(const HttpResponse& r, const string& key) {
+        if (r.status == 429) quota.exhausted(key);
+        else if (r.rateLimitRemaining >= 0) quota.sync(key, r.rateLimitRemaining);
+
+        bool good = usdaAnswered(r);
+        breaker.record(good);
+        if (good) latencies.add(r.elapsedMs);
+        else ++failures;
+        if (r.hedged) ++hedges;
+        if (r.hedgeWon) ++hedgeWins;
+    }
+}
+
+bool usdaAnswered(const HttpResponse& r) {
+    return r.ok && r.status != 429 && r.status < 500;
+}
+
+void configureUsdaClient(const UsdaClientOptions& opt) {
+    options = opt;
+    breaker.configure(opt.breakerFailures, chrono::milliseconds(opt.breakerOpenMs));
+    quota.configure(opt.apiKeys, opt.hourlyQuota);
+}
+
+UsdaClientStats usdaClientStats() {
+    UsdaClientStats st;
+    st.requests       = requests.load();
+    st.failures       = failures.load();
+    st.shortCircuited = shortCircuited.load();
+    st.hedges         = hedges.load();
+    st.hedgeWins      = hedgeWins.load();
+    st.breaker        = breaker.state();
+    st.p50Ms          = latencies.percentile(0.50);
+    st.p95Ms          = latencies.percentile(0.95);
+    st.hedgeAfterMs   = hedgeDelay();
+    st.quota          = quota.stats();
+    st.connectTimeoutMs = options.connectTimeoutMs;
+    st.timeoutMs        = options.timeoutMs;
+    return st;
+}
+
+vector<HttpResponse> usdaGetAll(const vector<string>& urls, int perRequestMs, int totalMs, UsdaPriority priority) {
+    typedef chrono::steady_clock Clock;
+    const Clock::time_point deadline = Clock::now() + chrono::milliseconds(totalMs);
+
+    // Queue for a quota token, which picks the key, then ask the breaker. In
+    // that order a half-open breaker's one probe slot is only taken by a
+    // request ready to go out, never held through a wait in the queue.
+    vector<HttpResponse> out(urls.size());
+    vector<string> allowed, keys;
+    vector<size_t> sent;
+    for (size_t i = 0; i < urls.size(); ++i) {
+        ++requests;
+        string key;
+        if (!quota.acquire(priority, deadline, key)) {
+            out[i].error = "quota exhausted";
+        } else if (!breaker.allow()) {
+            quota.refund(key);
+            ++shortCircuited;
+            out[i].error = "circuit open";
+        } else {
+            allowed.push_back(key.empty() ? urls[i] : urls[i] + "&api_key=" + urlEncode(key));
+            keys.push_back(key);
+            sent.push_back(i);
+        }
+    }
+    if (allowed.empty()) return out;
+
+    const int left = int(max<long long>(1, chrono::duration_cast<chrono::milliseconds>(deadline - Clock::now()).count()));
+    // A duplicate is a real USDA call too: it goes out only on a token of its url's key
+    vector<HttpResponse> responses = httpGetAll(allowed, min(perRequestMs, left), left,
+                                                options.connectTimeoutMs, hedgeDelay(),
+                                                [&](size_t r) { return quota.tryAcquireHedge(priority, keys[r]); });
+    for (size_t r = 0; r < responses.size(); ++r) {
+        recordOutcome(responses[r], keys[r]);
+        out[sent[r]] = move(responses[r]);
+    }
+    return out;
+}
+
+HttpResponse usdaGet(const string& url, UsdaPriority priority) {
+    return usdaGetAll({ url }, options.timeoutMs, options.timeoutMs, priority).front();
+}
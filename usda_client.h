@@ -0,0 +1,99 @@
+#ifndef USDA_CLIENT_H
+#define USDA_CLIENT_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "http_pool.h"
+#include "usda_quota.h"
+
+// Fails fast while an upstream is unhealthy. Closed, it lets everything through
+// and counts consecutive failures; `failureThreshold` of them open it. Open, it
+// refuses every call for `openFor`, then goes half-open and lets one probe
+// through: the probe's success closes it, its failure opens it again.
+class CircuitBreaker {
+public:
+    enum State { CLOSED, OPEN, HALF_OPEN };
+
+    CircuitBreaker(int failureThreshold, std::chrono::milliseconds openFor);
+
+    // True if the caller may make the call; it must then record() the outcome
+    bool allow();
+    void record(bool success);
+
+    State state() const;
+    void configure(int failureThreshold, std::chrono::milliseconds openFor);
+
+private:
+    mutable std::mutex lock;
+    State current = CLOSED;
+    int failures = 0;
+    int threshold;
+    std::chrono::milliseconds cooldown;
+    std::chrono::steady_clock::time_point openedAt;
+    bool probing = false;   // half-open and the probe is out
+};
+
+// The most recent successful latencies, for percentiles
+class LatencyWindow {
+public:
+    static const size_t CAPACITY = 256;
+
+    void add(long ms);
+    size_t count() const;
+    // p in [0, 1]; 0 with no samples
+    long percentile(double p) const;
+
+private:
+    mutable std::mutex lock;
+    long samples[CAPACITY] = {};
+    size_t filled = 0;
+    size_t next = 0;
+};
+
+struct UsdaClientOptions {
+    int connectTimeoutMs = 2000;
+    int timeoutMs        = 5000;    // whole request, connect included, for single searches
+    int breakerFailures  = 5;       // consecutive failures that open the breaker
+    int breakerOpenMs    = 30000;   // how long it stays open before a probe
+    int hedgeMinMs       = 50;      // never hedge sooner than this
+    size_t hedgeMinSamples = 20;    // latencies seen before p95 is trusted for hedging
+    std::vector<std::string> apiKeys;   // rotated by the quota scheduler; none = no api_key sent
+    int hourlyQuota = USDA_HOURLY_QUOTA;  // per key
+};
+
+struct UsdaClientStats {
+    uint64_t requests = 0;        // urls asked for, short-circuited ones included
+    uint64_t failures = 0;        // transport errors, timeouts and 5xx/429 answers
+    uint64_t shortCircuited = 0;  // refused by the open breaker without a request
+    uint64_t hedges = 0;          // duplicate requests sent
+    uint64_t hedgeWins = 0;       // duplicates that answered first
+    CircuitBreaker::State breaker = CircuitBreaker::CLOSED;
+    long p50Ms = 0;
+    long p95Ms = 0;
+    long hedgeAfterMs = 0;        // current hedge delay, 0 while there are too few samples
+    QuotaStats quota;
+    int connectTimeoutMs = 0;
+    int timeoutMs = 0;
+};
+
+// Replaces the defaults; call at startup, before the first request
+void configureUsdaClient(const UsdaClientOptions& options);
+UsdaClientStats usdaClientStats();
+
+// GETs against api.nal.usda.gov through the breaker and the quota scheduler,
+// with the configured connect timeout and a hedged duplicate for any url still
+// unanswered at the observed p95, if its key has a token to spare for it. Each url gets the api_key of the key its
+// quota token came from, so urls must not carry one. Time spent queueing for
+// quota counts against totalMs. A url refused by the breaker comes back !ok
+// with error "circuit open"; one that got no quota by then, "quota exhausted".
+HttpResponse usdaGet(const std::string& url, UsdaPriority priority = USDA_INTERACTIVE);
+std::vector<HttpResponse> usdaGetAll(const std::vector<std::string>& urls, int perRequestMs, int totalMs,
+                                     UsdaPriority priority = USDA_INTERACTIVE);
+
+// An answer worth using: delivered, and not a server error or rate limit
+bool usdaAnswered(const HttpResponse& r);
+
+#endif
@@ -0,0 +1,174 @@
+// usda_parse.cpp
+// Parsing of FoodData Central /foods/search and /foods responses, separate from the
+// network code so it can be benchmarked against recorded fixtures.
+#include "food_api.h"
+#include "json.hpp"
+#include <climits>
+#include <iostream>
+
+using json = nlohmann::json;
+using namespace std;
+
+namespace {
+    // SAX handler that appends foods to a FoodTable straight from the token
+    // stream. Only each food's fdcId, description and foodNutrients are kept;
+    // every other value is dropped as soon as the lexer hands it over, so no
+    // DOM is built.
+    //
+    // Two layouts are understood. /foods/search wraps the list in an object
+    // ({"foods": [...]}) and gives each nutrient as {nutrientId, nutrientNumber,
+    // value}. /foods returns a bare array and, in its full format, gives each
+    // nutrient as {nutrient: {id, number}, amount}. Depths count open containers;
+    // once the list is found, foods sit at foodDepth, their nutrients at
+    // foodDepth + 2 and a nested nutrient object at foodDepth + 3.
+    class FoodSearchSax : public nlohmann::json_sax<json> {
+    public:
+        FoodSearchSax(FoodTable& out, int maxResults) : results(out), maxResults(maxResults) {}
+
+        bool stopped = false;   // reached maxResults; the rest was not parsed
+        std::string error;
+
+        bool null() override { return true; }
+        bool boolean(bool) override { return true; }
+        bool number_integer(number_integer_t v) override { return number(double(v)); }
+        bool number_unsigned(number_unsigned_t v) override { return number(double(v)); }
+        bool number_float(number_float_t v, const string_t&) override { return number(v); }
+        bool binary(binary_t&) override { return true; }
+
+        bool string(string_t& v) override {
+            if (depth == foodDepth && field == FIELD_DESCRIPTION) description = move(v);
+            else if (field == FIELD_NUTRIENT_NUMBER && !source) source = nutrientByNumber(v);
+            field = FIELD_NONE;
+            return true;
+        }
+
+        bool key(string_t& k) override {
+            field = FIELD_NONE;
+            if (!foodDepth) {
+                if (depth == 1 && k == "foods") field = FIELD_FOODS;
+            } else if (depth == foodDepth) {
+                if (k == "fdcId") field = FIELD_FDC_ID;
+                else if (k == "description") field = FIELD_DESCRIPTION;
+                else if (k == "foodNutrients") field = FIELD_NUTRIENTS;
+            } else if (depth == foodDepth + 2 && inNutrients) {
+                if (k == "nutrientId") field = FIELD_NUTRIENT_ID;
+                else if (k == "nutrientNumber" || k == "number") field = FIELD_NUTRIENT_NUMBER;
+                else if (k == "value" || k == "amount") field = FIELD_VALUE;
+                else if (k == "nutrient") field = FIELD_NUTRIENT;
+            } else if (depth == foodDepth + 3 && inNutrient) {
+                // "id" only here: at the level above it is the FoodNutrient record's own id
+                if (k == "id") field = FIELD_NUTRIENT_ID;
+                else if (k == "number") field = FIELD_NUTRIENT_NUMBER;
+            }
+            return true;
+        }
+
+        bool start_object(size_t) override {
+            ++depth;
+            if (foodDepth && depth == foodDepth) {
+                fdcId = 0;
+                description = "Unknown";
+                collected.reset();
+            } else if (foodDepth && depth == foodDepth + 2 && inNutrients) {
+                source = nullptr;
+                nutrientValue = 0.0;
+            } else if (foodDepth && depth == foodDepth + 3 && field == FIELD_NUTRIENT) {
+                inNutrient = true;
+            }
+            field = FIELD_NONE;
+            return true;
+        }
+
+        bool end_object() override {
+            if (!foodDepth) {
+                // not in the list yet
+            } else if (depth == foodDepth + 3) {
+                inNutrient = false;
+            } else if (depth == foodDepth + 2 && inNutrients) {
+                collected.offer(source, nutrientValue);
+            } else if (depth == foodDepth) {
+                float amount[NUTRIENT_COUNT];
+                for (int n = 0; n < NUTRIENT_COUNT; ++n) amount[n] = float(collected.amount[n]);
+                results.add(fdcId, description, amount);
+                if (int(results.size()) >= maxResults) {
+                    stopped = true;
+                    return false;   // ends the parse
+                }
+            }
+            --depth;
+            field = FIELD_NONE;
+            return true;
+        }
+
+        bool start_array(size_t) override {
+            ++depth;
+            if (!foodDepth && (depth == 1 || (depth == 2 && field == FIELD_FOODS))) {
+                listDepth = depth;   // 1 for /foods' bare array, 2 for /foods/search's "foods"
+                foodDepth = depth + 1;
+            } else if (foodDepth && depth == foodDepth + 1 && field == FIELD_NUTRIENTS) {
+                inNutrients = true;
+            }
+            field = FIELD_NONE;
+            return true;
+        }
+
+        bool end_array() override {
+            if (depth == listDepth) listDepth = foodDepth = 0;
+            else if (foodDepth && depth == foodDepth + 1) inNutrients = false;
+            --depth;
+            field = FIELD_NONE;
+            return true;
+        }
+
+        bool parse_error(size_t, const std::string&, const nlohmann::detail::exception& e) override {
+            error = e.what();
+            return false;
+        }
+
+    private:
+        enum Field { FIELD_NONE, FIELD_FOODS, FIELD_FDC_ID, FIELD_DESCRIPTION, FIELD_NUTRIENTS,
+                     FIELD_NUTRIENT_ID, FIELD_NUTRIENT_NUMBER, FIELD_VALUE, FIELD_NUTRIENT };
+
+        FoodTable& results;
+        const int maxResults;
+        int depth = 0;
+        int listDepth = 0;          // depth of the food list while inside it, else 0
+        int foodDepth = 0;          // depth of a food object while inside the list, else 0
+        bool inNutrients = false;   // inside the current food's foodNutrients array
+        bool inNutrient = false;    // inside a nutrient's nested "nutrient" object
+        Field field = FIELD_NONE;   // what the next scalar value is
+        int fdcId = 0;                            // the current food's
+        std::string description;
+        NutrientCollector collected;              // the current food's nutrients
+        const NutrientSource* source = nullptr;   // the current nutrient's slot, if we keep it
+        double nutrientValue = 0.0;
+
+        bool number(double v) {
+            if (depth == foodDepth && field == FIELD_FDC_ID) fdcId = int(v);
+            else if (field == FIELD_NUTRIENT_ID && !source) source = nutrientById(int(v));
+            else if (field == FIELD_VALUE) nutrientValue = v;
+            field = FIELD_NONE;
+            return true;
+        }
+    };
+
+    FoodTable parseFoods(const std::string& response, int maxResults) {
+        FoodTable results;
+        FoodSearchSax sax(results, maxResults);
+        bool ok = json::sax_parse(response, &sax);
+        if (!ok && !sax.stopped) {
+            // Malformed input yields nothing rather than the foods before the error
+            cerr << "JSON parsing error: " << sax.error << endl;
+            results = FoodTable();
+        }
+        return results;
+    }
+}
+
+FoodTable parseFoodSearchResponse(const string& response, int maxResults) {
+    return parseFoods(response, maxResults);
+}
+
+FoodTable parseFoodListResponse(const string& response) {
+    return parseFoods(response, INT_MAX);
+}
@@ -0,0 +1,156 @@
+// usda_quota.cpp
+#include "usda_quota.h"
+#include <algorithm>
+
+using namespace std;
+
+void QuotaScheduler::configure(const vector<string>& keys, int hourlyQuota) {
+    lock_guard<mutex> guard(lock);
+    const double capacity = max(1, hourlyQuota);
+    buckets.clear();
+    for (const auto& key : keys) {
+        if (!key.empty()) buckets.push_back({ key, capacity, capacity });
+    }
+    perSecond = capacity / 3600.0;
+    refilled = Clock::now();
+    changed.notify_all();
+}
+
+void QuotaScheduler::refill(Clock::time_point now) {
+    double seconds = chrono::duration<double>(now - refilled).count();
+    refilled = now;
+    for (auto& b : buckets) b.tokens = min(b.capacity, b.tokens + seconds * perSecond);
+}
+
+QuotaScheduler::Bucket* QuotaScheduler::find(const string& key) {
+    for (auto& b : buckets) {
+        if (b.key == key) return &b;
+    }
+    return nullptr;
+}
+
+bool QuotaScheduler::acquire(UsdaPriority priority, Clock::time_point deadline, string& key) {
+    const Clock::time_point queuedAt = Clock::now();
+    unique_lock<mutex> guard(lock);
+    if (buckets.empty()) {
+        key.clear();
+        return true;
+    }
+
+    const pair<int, uint64_t> ticket(priority, nextTicket++);
+    waiting.insert(ticket);
+    for (;;) {
+        const Clock::time_point now = Clock::now();
+        refill(now);
+
+        // Only the head may take a token; background ones leave the reserve alone
+        Bucket* best = nullptr;
+        for (auto& b : buckets) {
+            if (!best || b.tokens > best->tokens) best = &b;
+        }
+        const double floor = priority == USDA_BACKGROUND ? best->capacity * USDA_BACKGROUND_RESERVE : 0.0;
+        const bool head = *waiting.begin() == ticket;
+        if (head && best->tokens >= floor + 1.0) {
+            best->tokens -= 1.0;
+            ++best->granted;
+            key = best->key;
+            waiting.erase(ticket);
+
+            double waitedMs = chrono::duration<double, milli>(now - queuedAt).count();
+            waitTotalMs[priority] += waitedMs;
+            waitMaxMs[priority] = max(waitMaxMs[priority], waitedMs);
+            ++waits[priority];
+            changed.notify_all();   // the next in line is now the head
+            return true;
+        }
+
+        if (now >= deadline) {
+            waiting.erase(ticket);
+            ++rejected;
+            changed.notify_all();
+            return false;
+        }
+
+        // The head sleeps until its token has refilled; the rest until the head moves
+        Clock::time_point wake = deadline;
+        if (head) {
+            double seconds = (floor + 1.0 - best->tokens) / perSecond;
+            wake = min(wake, now + chrono::duration_cast<Clock::duration>(chrono::duration<double>(seconds)));
+        }
+        changed.wait_until(guard, wake);
+    }
+}
+
+bool QuotaScheduler::tryAcquireHedge(UsdaPriority priority, const string& key) {
+    lock_guard<mutex> guard(lock);
+    if (buckets.empty()) return true;
+    Bucket* b = find(key);
+    if (!b) return false;
+    refill(Clock::now());
+    // Queued callers come first: a hedge only spends what nobody is waiting for
+    const double floor = priority == USDA_BACKGROUND ? b->capacity * USDA_BACKGROUND_RESERVE : 0.0;
+    if (!waiting.empty() || b->tokens < floor + 1.0) {
+        ++hedgesDenied;
+        return false;
+    }
+    b->tokens -= 1.0;
+    ++b->granted;
+    ++b->hedges;
+    return true;
+}
+
+void QuotaScheduler::refund(const string& key) {
+    lock_guard<mutex> guard(lock);
+    Bucket* b = find(key);
+    if (!b) return;
+    refill(Clock::now());
+    b->tokens = min(b->capacity, b->tokens + 1.0);
+    if (b->granted) --b->granted;
+    changed.notify_all();
+}
+
+void QuotaScheduler::sync(const string& key, long remaining) {
+    lock_guard<mutex> guard(lock);
+    Bucket* b = find(key);
+    if (!b || remaining < 0) return;
+    refill(Clock::now());
+    b->tokens = min(b->tokens, double(remaining));
+}
+
+void QuotaScheduler::exhausted(const string& key) {
+    lock_guard<mutex> guard(lock);
+    Bucket* b = find(key);
+    if (!b) return;
+    refill(Clock::now());
+    b->tokens = 0;
+    ++b->exhausted;
+}
+
+QuotaStats QuotaScheduler::stats() const {
+    lock_guard<mutex> guard(lock);
+    QuotaStats st;
+    // Report as of now without moving the refill clock
+    double seconds = chrono::duration<double>(Clock::now() - refilled).count();
+    for (const auto& b : buckets) {
+        QuotaKeyStats k;
+        k.key       = b.key.substr(0, 4) + "...";
+        k.tokens    = min(b.capacity, b.tokens + seconds * perSecond);
+        k.capacity  = b.capacity;
+        k.granted   = b.granted;
+        k.hedges    = b.hedges;
+        k.exhausted = b.exhausted;
+        st.remaining += k.tokens;
+        st.capacity  += k.capacity;
+        st.granted   += k.granted;
+        st.hedges    += k.hedges;
+        st.keys.push_back(k);
+    }
+    st.rejected = rejected;
+    st.hedgesDenied = hedgesDenied;
+    for (const auto& w : waiting) ++st.queued[w.first];
+    for (int p = 0; p < USDA_PRIORITIES; ++p) {
+        st.avgWaitMs[p] = waits[p] ? waitTotalMs[p] / double(waits[p]) : 0.0;
+        st.maxWaitMs[p] = waitMaxMs[p];
+    }
+    return st;
+}
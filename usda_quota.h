@@ -0,0 +1,109 @@
+#ifndef USDA_QUOTA_H
+#define USDA_QUOTA_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Default requests per hour per key (api.data.gov's standard limit)
+const int USDA_HOURLY_QUOTA = 1000;
+
+// Share of each bucket only interactive requests may spend, so background
+// refreshes cannot starve searches
+const double USDA_BACKGROUND_RESERVE = 0.1;
+
+// Who is asking: a user waiting on a search, or a background refresh
+enum UsdaPriority { USDA_INTERACTIVE, USDA_BACKGROUND, USDA_PRIORITIES };
+
+struct QuotaKeyStats {
+    std::string key;        // masked: first four characters only
+    double   tokens = 0;    // requests left in the bucket right now
+    double   capacity = 0;
+    uint64_t granted = 0;   // hedges included
+    uint64_t hedges = 0;    // tokens spent on hedged duplicates
+    uint64_t exhausted = 0; // 429s that emptied the bucket
+};
+
+struct QuotaStats {
+    std::vector<QuotaKeyStats> keys;
+    double   remaining = 0;               // summed over keys
+    double   capacity = 0;
+    uint64_t granted = 0;
+    uint64_t rejected = 0;                // callers whose deadline passed in the queue
+    uint64_t hedges = 0;                  // duplicates that got a token
+    uint64_t hedgesDenied = 0;            // duplicates not sent for want of one
+    size_t   queued[USDA_PRIORITIES] = {};
+    double   avgWaitMs[USDA_PRIORITIES] = {};   // over granted requests
+    double   maxWaitMs[USDA_PRIORITIES] = {};
+};
+
+// Rations upstream requests across one or more API keys. Every key has a token
+// bucket holding an hour's quota and refilling continuously at quota / 3600
+// per second. Callers queue in priority order (interactive before background,
+// first come first served within a priority). The head of the queue takes a
+// token from whichever key has the most left, so load spreads evenly across
+// the keys and a key that hit its limit is skipped until it refills. With no
+// keys configured nothing is rationed.
+class QuotaScheduler {
+public:
+    QuotaScheduler() = default;
+    QuotaScheduler(const QuotaScheduler&) = delete;
+    QuotaScheduler& operator=(const QuotaScheduler&) = delete;
+
+    // Replaces the keys; every bucket starts full
+    void configure(const std::vector<std::string>& keys, int hourlyQuota);
+
+    // Waits for a token until `deadline`. True with the key to use, false if
+    // the deadline passed first.
+    bool acquire(UsdaPriority priority, std::chrono::steady_clock::time_point deadline, std::string& key);
+
+    // A token from `key`'s own bucket for a hedged duplicate, only if one is
+    // there now (above the priority's reserve) and nobody is queued for it;
+    // never waits. True with no keys configured.
+    bool tryAcquireHedge(UsdaPriority priority, const std::string& key);
+
+    // Gives back a token acquire() handed out for a request that was not sent
+    void refund(const std::string& key);
+
+    // USDA reported `remaining` requests left for the key (X-RateLimit-Remaining)
+    void sync(const std::string& key, long remaining);
+    // USDA refused the key with 429: its bucket is empty whatever we counted
+    void exhausted(const std::string& key);
+
+    QuotaStats stats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Bucket {
+        std::string key;
+        double tokens;
+        double capacity;
+        uint64_t granted = 0;
+        uint64_t hedges = 0;
+        uint64_t exhausted = 0;
+    };
+
+    mutable std::mutex lock;
+    std::condition_variable changed;
+    std::vector<Bucket> buckets;
+    double perSecond = 0;            // refill rate of each bucket
+    Clock::time_point refilled;
+    std::set<std::pair<int, uint64_t>> waiting;   // (priority, ticket), head first
+    uint64_t nextTicket = 0;
+    uint64_t rejected = 0;
+    uint64_t hedgesDenied = 0;
+    double waitTotalMs[USDA_PRIORITIES] = {};
+    double waitMaxMs[USDA_PRIORITIES] = {};
+    uint64_t waits[USDA_PRIORITIES] = {};
+
+    void refill(Clock::time_point now);
+    Bucket* find(const std::string& key);
+};
+
+#endif